@@ -2,188 +2,124 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ecu.h"
-
-#define MAX_LINE 4096
-#define MAX_COLS 256
-
-static int split_csv(char *line, char *cols[], int maxcols) {
-    int count = 0;
-    char *p = line;
-    while (*p && count < maxcols) {
-        cols[count++] = p;
-        while (*p && *p != ',' && *p != '\r' && *p != '\n') p++;
-        if (*p == ',') { *p = '\0'; p++; }
-    }
-    if (count > 0) {
-        char *last = cols[count-1];
-        size_t n = strlen(last);
-        while (n && (last[n-1] == '\n' || last[n-1] == '\r')) last[--n] = '\0';
-    }
-    return count;
-}
-
-static int find_col(char *header_cols[], int ncols, const char *name) {
-    for (int i = 0; i < ncols; i++) if (strcmp(header_cols[i], name) == 0) return i;
-    return -1;
+#include "sim.h"
+#include "fleet.h"
+#include "sweep.h"
+#include "segment.h"
+#include "pipeline.h"
+#include "stream.h"
+#include "rle.h"
+#include "sens.h"
+#include "tune.h"
+#include "prof.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s <input.csv|.ecub> <output.csv|.ecub> [--flush batch|row|direct]\n"
+            "       %s --parallel [--threads N] <input> <output>\n"
+            "       %s --pipeline <input> <output> [--flush batch|row|direct]\n"
+            "       %s --stream [<input|-> [<output|->]]\n"
+            "       %s --resume <checkpoint> <input.csv> <output.csv>\n"
+            "       %s --fast-forward|--rle <input> <output>\n"
+            "       %s --fleet <dir|manifest> [--threads N]\n"
+            "       %s --sweep <calib-manifest|key=start:stop:step[,...]> <input.csv> [<output.csv>]\n"
+            "       %s --sensitivity <input> [<output.csv>]\n"
+            "       %s --tune <trace|dir|manifest> <calibration.txt> [--weights overshoot=W,settle=W,revcut=W] [--threads N]\n",
+            prog, prog, prog, prog, prog, prog, prog, prog, prog, prog);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <input.csv> <output.csv>\n", argv[0]);
+    const char *fleet_src = NULL;
+    const char *sweep_spec = NULL;
+    const char *tune_src = NULL;
+    const char *tune_weights = NULL;
+    int threads = 0;
+    int parallel = 0;
+    int pipeline = 0;
+    int stream = 0;
+    int sensitivity = 0;
+    int fast_forward = 0;       // 1 --fast-forward, 2 --rle (RLE output too)
+    const char *resume = NULL;
+    int flush = WRITER_FLUSH_BATCH;
+    const char *pos[2] = { NULL, NULL };
+    int npos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            fleet_src = argv[++i];
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep_spec = argv[++i];
+        } else if (strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            tune_src = argv[++i];
+        } else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+            tune_weights = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resume = argv[++i];
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = 1;
+        } else if (strcmp(argv[i], "--sensitivity") == 0) {
+            sensitivity = 1;
+        } else if (strcmp(argv[i], "--fast-forward") == 0) {
+            fast_forward = 1;
+        } else if (strcmp(argv[i], "--rle") == 0) {
+            fast_forward = 2;
+        } else if (strcmp(argv[i], "--parallel") == 0) {
+            parallel = 1;
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--flush") == 0 && i + 1 < argc) {
+            flush = writer_parse_policy(argv[++i]);
+            if (flush < 0) { usage(argv[0]); return 2; }
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (npos < 2) {
+            pos[npos++] = argv[i];
+        }
+    }
+    if (!fleet_src && !stream && npos < (sweep_spec || sensitivity || tune_src ? 1 : 2)) {
+        usage(argv[0]);
         return 2;
     }
 
-    const char *in_path  = argv[1];
-    const char *out_path = argv[2];
-
-    FILE *fin = fopen(in_path, "r");
-    if (!fin) { perror("open input"); return 3; }
-    FILE *fout = fopen(out_path, "w");
-    if (!fout) { perror("open output"); fclose(fin); return 4; }
+    PROF_INIT();
 
-    // --- Calibrations (SCR2..SCR11) ---
+    // --- Calibrations (SCR2..SCR11), loaded once ---
     const char *calib_env  = getenv("ECU_CALIB_PATH");
     const char *calib_path = (calib_env && calib_env[0]) ? calib_env : "app/calibration/calibration.txt";
-    int max_engine_speed = parse_max_engine_speed(calib_path, 2000);
-    int brake_gain       = parse_brake_gain(calib_path, 4);
-    double gear_mult[6]; parse_gear_multipliers(calib_path, gear_mult);
-
-    double cc_kp; int cc_max_step, cc_gear_min, cc_tmin, cc_tmax;
-    parse_cc_params(calib_path, &cc_kp, &cc_max_step, &cc_gear_min, &cc_tmin, &cc_tmax);
-
-    int drag_rpm = parse_drag_rpm_per_iter(calib_path, 5);
-
-    int idle_target, idle_max_step, idle_gear_max; double idle_kp;
-    parse_idle_params(calib_path, &idle_target, &idle_kp, &idle_max_step, &idle_gear_max);
-
-    int slew_rise, slew_fall; parse_slew_params(calib_path, &slew_rise, &slew_fall);
-
-    int acc_overlap_deg, brk_overlap_deg, limp_rows_confirm, limp_max_speed, limp_clear_on_off;
-    double limp_acc_gain_scale;
-    parse_limp_params(calib_path,
-                      &acc_overlap_deg, &brk_overlap_deg, &limp_rows_confirm,
-                      &limp_max_speed, &limp_acc_gain_scale, &limp_clear_on_off);
-
-    int rev_soft, rev_hard, rev_hyst, rev_cut_step, rev_cooldown_rows;
-    parse_rev_params(calib_path,
-                     &rev_soft, &rev_hard, &rev_hyst, &rev_cut_step, &rev_cooldown_rows);
-
-    int bto_brake_deg, bto_acc_min_deg; double bto_acc_scale;
-    parse_bto_params(calib_path, &bto_brake_deg, &bto_acc_min_deg, &bto_acc_scale);
-
-    char line[MAX_LINE];
-    char *cols[MAX_COLS];
-
-    // --- Header ---
-    if (!fgets(line, sizeof(line), fin)) {
-        fprintf(stderr, "empty input\n");
-        fclose(fin); fclose(fout);
-        return 5;
+    ecu_calib_t cal;
+    if (ecu_calib_load(calib_path, &cal, stderr) < 0) {
+        fprintf(stderr, "calib: cannot open %s, using defaults\n", calib_path);
     }
-    int hcols      = split_csv(line, cols, MAX_COLS);
-    int time_idx   = find_col(cols, hcols, "time");
-    int ign_idx    = find_col(cols, hcols, "ignition_switch");
-    int acc_idx    = find_col(cols, hcols, "acc_pedal_position");
-    int brk_idx    = find_col(cols, hcols, "brake_pedal_position");
-    int gear_idx   = find_col(cols, hcols, "current_gear");
-    int cc_en_idx  = find_col(cols, hcols, "cruise_enable");
-    int cc_tgt_idx = find_col(cols, hcols, "cruise_target_speed");
 
-    if (ign_idx < 0) {
-        fprintf(stderr, "input header must contain 'ignition_switch'\n");
-        fclose(fin); fclose(fout);
-        return 6;
+    if (fleet_src) {
+        return fleet_run(&cal, fleet_src, threads, stdout);
     }
-
-    // --- Output header ---
-    fprintf(fout, "time,engine_state,engine_speed\n");
-
-    long tgen = 0;
-    int engine_speed = 0; // last *emitted* speed
-
-    // SCR9: persistent limp state
-    int limp_mode = 0;
-    int overlap_run_count = 0;
-
-    // SCR10: rev limiter state
-    int hard_cut_active = 0;
-    int hard_cut_cooldown = 0;
-
-    // --- Rows ---
-    while (fgets(line, sizeof(line), fin)) {
-        int n = split_csv(line, cols, MAX_COLS);
-        if (n == 0) continue;
-
-        long t = tgen;
-        if (time_idx >= 0 && time_idx < n && cols[time_idx][0]) t = strtol(cols[time_idx], NULL, 10);
-
-        int ign = 0;
-        if (ign_idx < n && cols[ign_idx][0]) ign = (int)strtol(cols[ign_idx], NULL, 10);
-        int engine_state = compute_engine_state(ign);
-
-        int acc_deg = 0;
-        if (acc_idx >= 0 && acc_idx < n && cols[acc_idx][0]) acc_deg = (int)strtol(cols[acc_idx], NULL, 10);
-
-        int brk_deg = 0;
-        if (brk_idx >= 0 && brk_idx < n && cols[brk_idx][0]) brk_deg = (int)strtol(cols[brk_idx], NULL, 10);
-
-        int gear = 3;
-        if (gear_idx >= 0 && gear_idx < n && cols[gear_idx][0]) gear = (int)strtol(cols[gear_idx], NULL, 10);
-
-        int cc_en = 0;
-        if (cc_en_idx >= 0 && cc_en_idx < n && cols[cc_en_idx][0]) cc_en = (int)strtol(cols[cc_en_idx], NULL, 10);
-
-        int cc_tgt = 0;
-        if (cc_tgt_idx >= 0 && cc_tgt_idx < n && cols[cc_tgt_idx][0]) cc_tgt = (int)strtol(cols[cc_tgt_idx], NULL, 10);
-
-        // SCR9: update limp state using raw pedals (plausibility)
-        update_limp_state(
-            engine_state, acc_deg, brk_deg,
-            acc_overlap_deg, brk_overlap_deg, limp_rows_confirm, limp_clear_on_off,
-            &limp_mode, &overlap_run_count
-        );
-
-        // Keep previously *emitted* speed for slew limiting and rev-limiter reference
-        int prev_out = engine_speed;
-
-        // SCR11: compute effective accelerator for baseline (non-latching BTO)
-        int eff_acc_deg = apply_bto_effective_acc(
-            acc_deg, brk_deg,
-            bto_brake_deg, bto_acc_min_deg, bto_acc_scale
-        );
-
-        // SCR2..SCR7 provisional (use eff_acc_deg)
-        int provisional = update_engine_speed_cc_drag_idle(
-            engine_state,
-            eff_acc_deg, brk_deg, gear,
-            prev_out, max_engine_speed,
-            brake_gain, gear_mult,
-            cc_en, cc_tgt,
-            cc_kp, cc_max_step, cc_gear_min, cc_tmin, cc_tmax,
-            drag_rpm,
-            idle_target, idle_kp, idle_max_step, idle_gear_max
-        );
-
-        // SCR9: limp cap (minimal)
-        provisional = apply_limp_cap(provisional, max_engine_speed, limp_mode, limp_max_speed);
-
-        // SCR10: rev limiter (after SCR9, before SCR8)
-        provisional = apply_rev_limiter(
-            engine_state, prev_out, provisional, max_engine_speed,
-            &hard_cut_active, &hard_cut_cooldown,
-            rev_soft, rev_hard, rev_hyst, rev_cut_step, rev_cooldown_rows
-        );
-
-        // SCR8: slew-rate limiting vs prev_out
-        engine_speed = apply_slew_limit(
-            engine_state, prev_out, provisional, max_engine_speed, slew_rise, slew_fall
-        );
-
-        fprintf(fout, "%ld,%d,%d\n", t, engine_state, engine_speed);
-        tgen++;
+    if (sweep_spec) {
+        return sweep_run(&cal, sweep_spec, pos[0], pos[1], stdout);
     }
-
-    fclose(fin);
-    fclose(fout);
-    return 0;
+    if (tune_src) {
+        return tune_run(&cal, calib_path, tune_src, pos[0], tune_weights, threads, stdout);
+    }
+    if (sensitivity) {
+        return sens_run(&cal, pos[0], pos[1], stdout);
+    }
+    if (stream) {
+        return stream_run(&cal, calib_path, pos[0] ? pos[0] : "-", pos[1] ? pos[1] : "-", stderr);
+    }
+    if (resume) {
+        return sim_resume_csv(&cal, pos[0], pos[1], (writer_flush_t)flush, resume, NULL);
+    }
+    if (fast_forward) {
+        return rle_run(&cal, pos[0], pos[1], fast_forward == 2, (writer_flush_t)flush, stderr);
+    }
+    if (pipeline) {
+        return pipeline_run(&cal, pos[0], pos[1], (writer_flush_t)flush, stderr);
+    }
+    if (parallel) {
+        return segment_run(&cal, pos[0], pos[1], threads, (writer_flush_t)flush, stderr);
+    }
+    return sim_run_csv(&cal, pos[0], pos[1], (writer_flush_t)flush, NULL);
 }
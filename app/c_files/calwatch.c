@@ -0,0 +1,157 @@
+// app/c_files/calwatch.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "calwatch.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+struct calwatch {
+    const char *path;
+    FILE *log;
+
+    ecu_calib_t *cur;           // row thread: the calibration in use
+    ecu_calib_t *next;          // published by the watcher, NULL when none
+    int swaps;
+
+    unsigned long long last_hash;   // watcher: last calibration published
+    pthread_t thread;
+    int ifd, wd;
+    int stop_pipe[2];
+};
+
+#ifdef __linux__
+// ======================== Watcher thread ========================
+// Parses and checks the file; publishes it unless it is rejected or
+// changes nothing. A calibration published earlier but not yet picked up
+// is replaced (and freed here: the row thread never saw it).
+static void reload(calwatch_t *w) {
+    ecu_calib_t *cal = malloc(sizeof(*cal));
+    if (!cal) return;
+    int applied = ecu_calib_load(w->path, cal, w->log);
+
+    const char *why = NULL;
+    if (applied < 0)                 why = "cannot open";
+    else if (applied == 0)           why = "no keys";
+    else if (cal->unknown_keys)      why = "unknown keys";
+    else if (cal->duplicate_keys)    why = "duplicate keys";
+    else if (cal->rejected_values)   why = "bad values";
+    if (why) {
+        fprintf(w->log, "calib: %s: reload rejected (%s), keeping the current calibration\n", w->path, why);
+        free(cal);
+        return;
+    }
+    unsigned long long h = ecu_calib_hash(cal);
+    if (h == w->last_hash) { free(cal); return; }
+    w->last_hash = h;
+
+    ecu_calib_t *stale = __atomic_exchange_n(&w->next, cal, __ATOMIC_ACQ_REL);
+    free(stale);
+}
+
+static const char *base_name(const char *path) {
+    const char *s = strrchr(path, '/');
+    return s ? s + 1 : path;
+}
+
+static void *watch_main(void *arg) {
+    calwatch_t *w = arg;
+    const char *name = base_name(w->path);
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        struct pollfd fds[2] = { { w->ifd, POLLIN, 0 }, { w->stop_pipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        ssize_t n = read(w->ifd, buf, sizeof(buf));
+        if (n <= 0) continue;
+        int hit = 0;
+        for (char *p = buf; p < buf + n; ) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            if (ev->len && strcmp(ev->name, name) == 0) hit = 1;
+            p += sizeof(*ev) + ev->len;
+        }
+        if (hit) reload(w);
+    }
+    return NULL;
+}
+#endif
+
+// ======================== API ========================
+calwatch_t *calwatch_start(const char *path, const ecu_calib_t *initial, FILE *log) {
+#ifdef __linux__
+    calwatch_t *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->path = path;
+    w->log = log;
+    w->ifd = -1;
+    w->stop_pipe[0] = w->stop_pipe[1] = -1;
+    w->cur = malloc(sizeof(*w->cur));
+    if (!w->cur) { free(w); return NULL; }
+    *w->cur = *initial;
+    w->last_hash = ecu_calib_hash(initial);
+
+    // Watch the directory: a save by rename replaces the inode.
+    char dir[4096];
+    const char *slash = strrchr(path, '/');
+    if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path) + (slash == path), path);
+    else       snprintf(dir, sizeof(dir), ".");
+
+    w->ifd = inotify_init1(IN_CLOEXEC);
+    if (w->ifd >= 0) w->wd = inotify_add_watch(w->ifd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (w->ifd < 0 || w->wd < 0 || pipe(w->stop_pipe) != 0 ||
+        pthread_create(&w->thread, NULL, watch_main, w) != 0) {
+        fprintf(log, "calib: cannot watch %s: %s\n", dir, strerror(errno));
+        if (w->stop_pipe[0] >= 0) { close(w->stop_pipe[0]); close(w->stop_pipe[1]); }
+        if (w->ifd >= 0) close(w->ifd);
+        free(w->cur);
+        free(w);
+        return NULL;
+    }
+    return w;
+#else
+    (void)initial;
+    fprintf(log, "calib: %s: hot reload needs inotify (Linux)\n", path);
+    return NULL;
+#endif
+}
+
+const ecu_calib_t *calwatch_current(calwatch_t *w, long row) {
+    if (__atomic_load_n(&w->next, __ATOMIC_RELAXED)) {
+        ecu_calib_t *fresh = __atomic_exchange_n(&w->next, NULL, __ATOMIC_ACQUIRE);
+        if (fresh) {
+            free(w->cur);   // only this thread ever read it
+            w->cur = fresh;
+            w->swaps++;
+            fprintf(w->log, "calib: %s reloaded, in effect from row %ld\n", w->path, row);
+        }
+    }
+    return w->cur;
+}
+
+int calwatch_swaps(const calwatch_t *w) {
+    return w->swaps;
+}
+
+void calwatch_stop(calwatch_t *w) {
+    if (!w) return;
+#ifdef __linux__
+    close(w->stop_pipe[1]);     // the watcher's poll() sees the hang-up
+    pthread_join(w->thread, NULL);
+    close(w->stop_pipe[0]);
+    close(w->ifd);
+#endif
+    free(w->next);
+    free(w->cur);
+    free(w);
+}
@@ -0,0 +1,48 @@
+// app/c_files/cases.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glob.h>
+#include "cases.h"
+
+static void calib_for_case(const char *calib_dir, int scr, const char *case_name, char *out, size_t cap) {
+    static const char *const forms[2] = { "%s/calib_scr%d_%s.txt", "%s/calib_scr%d_%s_*.txt" };
+    char pat[1100];
+    for (int f = 0; f < 2; f++) {
+        glob_t g;
+        snprintf(pat, sizeof(pat), forms[f], calib_dir, scr, case_name);
+        int found = glob(pat, 0, NULL, &g) == 0 && g.gl_pathc > 0;
+        if (found) snprintf(out, cap, "%s", g.gl_pathv[0]);
+        globfree(&g);
+        if (found) return;
+    }
+    snprintf(out, cap, "%s/calibration.txt", calib_dir);
+}
+
+int cases_find(const char *cases_dir, const char *calib_dir, ecu_case_t **out) {
+    *out = NULL;
+    char pat[1100];
+    snprintf(pat, sizeof(pat), "%s/SCR*/case*", cases_dir);
+    glob_t g;
+    if (glob(pat, GLOB_ONLYDIR, NULL, &g) != 0) return -1;
+
+    ecu_case_t *cs = calloc(g.gl_pathc, sizeof(*cs));
+    if (!cs) { globfree(&g); return -1; }
+    int n = 0;
+    for (size_t i = 0; i < g.gl_pathc; i++) {
+        const char *dir = g.gl_pathv[i];
+        const char *case_name = strrchr(dir, '/') + 1;
+        const char *scr_name = strstr(dir + strlen(cases_dir), "SCR");
+        if (!scr_name) continue;
+
+        ecu_case_t *c = &cs[n++];
+        snprintf(c->name, sizeof(c->name), "%s", scr_name);
+        c->scr = atoi(scr_name + 3);
+        snprintf(c->input, sizeof(c->input), "%s/%s.csv", dir, case_name);
+        snprintf(c->golden, sizeof(c->golden), "%s/golden.csv", dir);
+        calib_for_case(calib_dir, c->scr, case_name, c->calib, sizeof(c->calib));
+    }
+    globfree(&g);
+    *out = cs;
+    return n;
+}
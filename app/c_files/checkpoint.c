@@ -0,0 +1,105 @@
+// app/c_files/checkpoint.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "checkpoint.h"
+
+// On-disk layout (native little-endian); check covers every byte before it.
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint64_t calib_hash;
+    uint64_t header_hash;
+    uint64_t offset;
+    uint64_t out_bytes;
+    int64_t  rows;
+    int32_t  engine_speed;
+    int32_t  engine_state;
+    int32_t  limp_mode;
+    int32_t  overlap_run_count;
+    int32_t  hard_cut_active;
+    int32_t  hard_cut_cooldown;
+    uint64_t check;
+} ckpt_file_t;
+
+static uint64_t ckpt_check(const ckpt_file_t *f) {
+    const unsigned char *p = (const unsigned char *)f;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < offsetof(ckpt_file_t, check); i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int ckpt_load(const char *path, ecu_checkpoint_t *ck) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        if (errno == ENOENT) return 1;
+        fprintf(stderr, "checkpoint %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    ckpt_file_t d;
+    size_t got = fread(&d, 1, sizeof(d), f);
+    fclose(f);
+    if (got != sizeof(d) || memcmp(d.magic, CKPT_MAGIC, 4) != 0 || d.check != ckpt_check(&d)) {
+        fprintf(stderr, "checkpoint %s: not a valid checkpoint\n", path);
+        return -1;
+    }
+    if (d.version != CKPT_VERSION) {
+        fprintf(stderr, "checkpoint %s: version %u, expected %u\n", path, (unsigned)d.version, CKPT_VERSION);
+        return -1;
+    }
+
+    memset(ck, 0, sizeof(*ck));
+    ecu_state_init(&ck->state);
+    ck->state.engine_speed      = d.engine_speed;
+    ck->state.engine_state      = d.engine_state;
+    ck->state.limp_mode         = d.limp_mode;
+    ck->state.overlap_run_count = d.overlap_run_count;
+    ck->state.hard_cut_active   = d.hard_cut_active;
+    ck->state.hard_cut_cooldown = d.hard_cut_cooldown;
+    ck->rows        = d.rows;
+    ck->offset      = d.offset;
+    ck->out_bytes   = d.out_bytes;
+    ck->calib_hash  = d.calib_hash;
+    ck->header_hash = d.header_hash;
+    return 0;
+}
+
+int ckpt_save(const char *path, const ecu_checkpoint_t *ck) {
+    ckpt_file_t d;
+    memset(&d, 0, sizeof(d));
+    memcpy(d.magic, CKPT_MAGIC, 4);
+    d.version           = CKPT_VERSION;
+    d.calib_hash        = ck->calib_hash;
+    d.header_hash       = ck->header_hash;
+    d.offset            = ck->offset;
+    d.out_bytes         = ck->out_bytes;
+    d.rows              = ck->rows;
+    d.engine_speed      = ck->state.engine_speed;
+    d.engine_state      = ck->state.engine_state;
+    d.limp_mode         = ck->state.limp_mode;
+    d.overlap_run_count = ck->state.overlap_run_count;
+    d.hard_cut_active   = ck->state.hard_cut_active;
+    d.hard_cut_cooldown = ck->state.hard_cut_cooldown;
+    d.check             = ckpt_check(&d);
+
+    size_t n = strlen(path);
+    char *tmp = malloc(n + sizeof(".tmp"));
+    if (!tmp) return -1;
+    memcpy(tmp, path, n);
+    strcpy(tmp + n, ".tmp");
+
+    FILE *f = fopen(tmp, "wb");
+    int ok = f && fwrite(&d, sizeof(d), 1, f) == 1;
+    if (f && fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "checkpoint %s: %s\n", path, strerror(errno));
+        remove(tmp);
+    }
+    free(tmp);
+    return ok ? 0 : -1;
+}
@@ -2,7 +2,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
 #include "ecu.h"
+#include "prof.h"
 
 #define ACC_BASE_GAIN_RPM_PER_DEG 2.0  // SCR2 base accel gain
 
@@ -21,72 +24,437 @@ static int round_to_int(double x) {
     return (int)(x + (x >= 0.0 ? 0.5 : -0.5));
 }
 
-// ======================== SCR1 ==============================
-int compute_engine_state(int ignition_switch) {
-    return ignition_switch ? 1 : 0;
+// ---- Q ECU_Q_BITS fixed point ----
+#define Q_ONE  (1LL << ECU_Q_BITS)
+#define Q_HALF (1LL << (ECU_Q_BITS - 1))
+
+static long long to_q(double x) {
+    return (long long)(x * (double)Q_ONE + (x >= 0.0 ? 0.5 : -0.5));
 }
 
-// ======================== SCR2 ==============================
-int parse_max_engine_speed(const char *calib_path, int fallback_rpm) {
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return fallback_rpm;
+static long long int_q(int v) {
+    return (long long)v * Q_ONE;
+}
 
-    char line[512];
-    int maxrpm = fallback_rpm;
-    while (fgets(line, sizeof(line), f)) {
-        int val = 0;
-        if (sscanf(line, " max_engine_speed %*[^0-9]%d", &val) == 1 && val > 0) {
-            maxrpm = val;
-            break;
+// round_to_int() on a Q value: half away from zero.
+static int q_round(long long v) {
+    return v >= 0 ? (int)((v + Q_HALF) >> ECU_Q_BITS) : -(int)((-v + Q_HALF) >> ECU_Q_BITS);
+}
+
+static long long clamp_q(long long v, long long lo, long long hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// ==================== Calibration loader ====================
+// One pass over calibration.txt. Each key is looked up in a sorted table
+// (bsearch) that says where it lives in ecu_calib_t and how the legacy
+// parse_* function sanitised it, so the per-SCR parsers are now views.
+typedef enum {
+    CK_INT_POSITIVE_FIRST,  // keep first value > 0 (SCR2)
+    CK_INT_NONNEG_FIRST,    // keep first value >= 0 (SCR3, SCR6)
+    CK_INT_RAW,             // last value wins, unchecked
+    CK_INT_CLAMP0,          // negative -> 0
+    CK_INT_MIN1,            // < 1 -> 1
+    CK_INT_BOOL,            // non-zero -> 1
+    CK_DBL_RAW,
+    CK_DBL_UNIT             // clamped to [0, 1]
+} calib_rule_t;
+
+typedef struct {
+    const char  *name;
+    size_t       offset;
+    calib_rule_t rule;
+} calib_key_t;
+
+#define CK(field, rule) { #field, offsetof(ecu_calib_t, field), rule }
+
+// Must stay sorted by strcmp() order: looked up with bsearch().
+static const calib_key_t CALIB_KEYS[] = {
+    CK(acc_overlap_deg,              CK_INT_CLAMP0),
+    CK(brake_gain_rpm_per_deg,       CK_INT_NONNEG_FIRST),
+    CK(brk_overlap_deg,              CK_INT_CLAMP0),
+    CK(bto_acc_min_deg,              CK_INT_CLAMP0),
+    CK(bto_acc_scale,                CK_DBL_UNIT),
+    CK(bto_brake_deg,                CK_INT_CLAMP0),
+    CK(bto_release_ramp_rows,        CK_INT_CLAMP0),
+    CK(bto_release_reset_on_ign_off, CK_INT_BOOL),
+    CK(cc_activation_gear_min,       CK_INT_RAW),
+    CK(cc_kp,                        CK_DBL_RAW),
+    CK(cc_max_step_per_iter,         CK_INT_RAW),
+    CK(cc_target_max,                CK_INT_RAW),
+    CK(cc_target_min,                CK_INT_RAW),
+    CK(drag_rpm_per_iter,            CK_INT_NONNEG_FIRST),
+    { "gear_acc_multiplier_g1", offsetof(ecu_calib_t, gear_mult) + 1 * sizeof(double), CK_DBL_RAW },
+    { "gear_acc_multiplier_g2", offsetof(ecu_calib_t, gear_mult) + 2 * sizeof(double), CK_DBL_RAW },
+    { "gear_acc_multiplier_g3", offsetof(ecu_calib_t, gear_mult) + 3 * sizeof(double), CK_DBL_RAW },
+    { "gear_acc_multiplier_g4", offsetof(ecu_calib_t, gear_mult) + 4 * sizeof(double), CK_DBL_RAW },
+    { "gear_acc_multiplier_g5", offsetof(ecu_calib_t, gear_mult) + 5 * sizeof(double), CK_DBL_RAW },
+    CK(idle_activation_gear_max,     CK_INT_RAW),
+    CK(idle_kp,                      CK_DBL_RAW),
+    CK(idle_max_step_per_iter,       CK_INT_RAW),
+    CK(idle_target_speed,            CK_INT_RAW),
+    CK(limp_acc_gain_scale,          CK_DBL_UNIT),
+    CK(limp_clear_on_ignition_off,   CK_INT_BOOL),
+    CK(limp_max_speed,               CK_INT_CLAMP0),
+    CK(limp_rows_confirm,            CK_INT_MIN1),
+    CK(max_engine_speed,             CK_INT_POSITIVE_FIRST),
+    CK(rev_cut_cooldown_rows,        CK_INT_CLAMP0),
+    CK(rev_hard_cut_step,            CK_INT_CLAMP0),
+    CK(rev_hard_limit,               CK_INT_CLAMP0),
+    CK(rev_hysteresis,               CK_INT_CLAMP0),
+    CK(rev_soft_limit,               CK_INT_CLAMP0),
+    CK(slew_max_fall_per_iter,       CK_INT_CLAMP0),
+    CK(slew_max_rise_per_iter,       CK_INT_CLAMP0),
+};
+#undef CK
+
+#define CALIB_NKEYS ((int)(sizeof(CALIB_KEYS) / sizeof(CALIB_KEYS[0])))
+_Static_assert(sizeof(CALIB_KEYS) / sizeof(CALIB_KEYS[0]) <= 64, "present and key_lines hold one slot per key");
+
+typedef struct {
+    const char *s;
+    size_t      n;
+} calib_name_t;
+
+static int calib_key_cmp(const void *name, const void *entry) {
+    const calib_name_t *k = (const calib_name_t *)name;
+    const char *e = ((const calib_key_t *)entry)->name;
+    int c = strncmp(k->s, e, k->n);
+    if (c != 0) return c;
+    return e[k->n] ? -1 : 0;
+}
+
+static int calib_key_index(const char *s, size_t n) {
+    calib_name_t k = { s, n };
+    const calib_key_t *e = bsearch(&k, CALIB_KEYS, CALIB_NKEYS, sizeof(CALIB_KEYS[0]), calib_key_cmp);
+    return e ? (int)(e - CALIB_KEYS) : -1;
+}
+
+static int is_key_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+void ecu_calib_defaults(ecu_calib_t *cal) {
+    memset(cal, 0, sizeof(*cal));
+    cal->max_engine_speed       = 2000;
+    cal->brake_gain_rpm_per_deg = 4;
+    cal->gear_mult[0] = 0.0;   // unused
+    cal->gear_mult[1] = 0.60;
+    cal->gear_mult[2] = 0.85;
+    cal->gear_mult[3] = 1.00;
+    cal->gear_mult[4] = 1.10;
+    cal->gear_mult[5] = 1.20;
+
+    cal->cc_kp                  = 0.2;
+    cal->cc_max_step_per_iter   = 30;
+    cal->cc_activation_gear_min = 3;
+    cal->cc_target_min          = 300;
+    cal->cc_target_max          = 2000;
+
+    cal->drag_rpm_per_iter = 5;
+
+    cal->idle_target_speed        = 600;
+    cal->idle_kp                  = 0.2;
+    cal->idle_max_step_per_iter   = 15;
+    cal->idle_activation_gear_max = 5;
+
+    cal->slew_max_rise_per_iter = 50;
+    cal->slew_max_fall_per_iter = 80;
+
+    cal->acc_overlap_deg            = 10;
+    cal->brk_overlap_deg            = 10;
+    cal->limp_rows_confirm          = 2;
+    cal->limp_max_speed             = 300;
+    cal->limp_acc_gain_scale        = 0.3;
+    cal->limp_clear_on_ignition_off = 1;
+
+    cal->rev_soft_limit        = 1800;
+    cal->rev_hard_limit        = 1950;
+    cal->rev_hysteresis        = 50;
+    cal->rev_hard_cut_step     = 60;
+    cal->rev_cut_cooldown_rows = 2;
+
+    cal->bto_brake_deg   = 10;
+    cal->bto_acc_min_deg = 5;
+    cal->bto_acc_scale   = 0.0; // full cut by default
+
+    cal->bto_release_ramp_rows        = 3;
+    cal->bto_release_reset_on_ign_off = 1;
+
+    ecu_calib_prepare(cal);
+}
+
+// Pedal math as tables. prev and the brake term are integers, so on a
+// non-cruise row round(prev + a - b) == prev + round(a) - b and the accel
+// term can be rounded when the table is built - unless a lands so near .5
+// that the row's double sum rounds either way depending on prev. Such
+// entries hold LUT_DOUBLE and those rows keep the double expression.
+// SCR11 needs no such care: its entries are the step's own expression.
+#define LUT_DOUBLE      INT_MIN
+#define LUT_HALF_MARGIN 1e-6
+#define LUT_MAX_RPM     1e7
+
+static void prepare_luts(ecu_calib_t *cal) {
+    const long long bg = cal->brake_gain_rpm_per_deg;
+    const int brake_ok = bg * 45 < (long long)LUT_MAX_RPM && bg * 45 > -(long long)LUT_MAX_RPM;
+    for (int b = 0; b <= 45; b++) cal->run.brake_lut[b] = brake_ok ? (int)(bg * b) : 0;
+
+    for (int g = 0; g < 6; g++) {
+        for (int a = 0; a <= 45; a++) {
+            double x = (double)a * cal->run.acc_gain[g];
+            int r = LUT_DOUBLE;
+            if (brake_ok && x > -LUT_MAX_RPM && x < LUT_MAX_RPM) {
+                r = round_to_int(x);
+                double d = x - (double)r;
+                if (0.5 - (d < 0.0 ? -d : d) < LUT_HALF_MARGIN) r = LUT_DOUBLE;
+            }
+            cal->run.acc_lut[g][a] = r;
+        }
+    }
+
+    for (int b = 0; b <= 45; b++) {
+        for (int a = 0; a <= 45; a++) {
+            int eff = a;
+            if (b >= cal->run.bto_brake && a >= cal->run.bto_acc_min) {
+                eff = clamp_int(round_to_int((double)a * cal->run.bto_scale), 0, 45);
+            }
+            cal->run.bto_eff[b][a] = (unsigned char)eff;
         }
     }
-    fclose(f);
-    return maxrpm;
 }
 
-// ======================== SCR3 ==============================
-int parse_brake_gain(const char *calib_path, int fallback_gain) {
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return fallback_gain;
+void ecu_calib_prepare(ecu_calib_t *cal) {
+    int max = cal->max_engine_speed;
+
+    for (int g = 0; g < 6; g++) cal->run.acc_gain[g] = ACC_BASE_GAIN_RPM_PER_DEG * cal->gear_mult[g];
+    cal->run.cc_target_hi = (cal->cc_target_max < max) ? cal->cc_target_max : max;
+    cal->run.drag         = cal->drag_rpm_per_iter >= 0 ? cal->drag_rpm_per_iter : 0;
+
+    cal->run.slew_rise = cal->slew_max_rise_per_iter < 0 ? 0 : cal->slew_max_rise_per_iter;
+    cal->run.slew_fall = cal->slew_max_fall_per_iter < 0 ? 0 : cal->slew_max_fall_per_iter;
+
+    cal->run.acc_overlap = cal->acc_overlap_deg < 0 ? 0 : cal->acc_overlap_deg;
+    cal->run.brk_overlap = cal->brk_overlap_deg < 0 ? 0 : cal->brk_overlap_deg;
+    cal->run.limp_need   = cal->limp_rows_confirm < 1 ? 1 : cal->limp_rows_confirm;
+    cal->run.limp_cap    = clamp_int(cal->limp_max_speed, 0, max);
+
+    int soft = cal->rev_soft_limit < 0 ? 0 : cal->rev_soft_limit;
+    int hard = cal->rev_hard_limit < 0 ? 0 : cal->rev_hard_limit;
+    if (soft > max) soft = max;
+    if (hard > max) hard = max;
+    if (soft >= hard) soft = (hard > 0) ? (hard - 1) : 0;
+    cal->run.rev_soft       = soft;
+    cal->run.rev_hard       = hard;
+    cal->run.rev_hysteresis = cal->rev_hysteresis < 0 ? 0 : cal->rev_hysteresis;
+    cal->run.rev_cut_step   = cal->rev_hard_cut_step < 0 ? 0 : cal->rev_hard_cut_step;
+    cal->run.rev_cooldown   = cal->rev_cut_cooldown_rows < 0 ? 0 : cal->rev_cut_cooldown_rows;
+
+    cal->run.bto_brake   = cal->bto_brake_deg < 0 ? 0 : cal->bto_brake_deg;
+    cal->run.bto_acc_min = cal->bto_acc_min_deg < 0 ? 0 : cal->bto_acc_min_deg;
+    cal->run.bto_scale   = clamp_double(cal->bto_acc_scale, 0.0, 1.0);
+
+    for (int g = 0; g < 6; g++) cal->run.acc_gain_q[g] = to_q(cal->run.acc_gain[g]);
+    cal->run.cc_kp_q     = to_q(cal->cc_kp);
+    cal->run.idle_kp_q   = to_q(cal->idle_kp);
+
+    prepare_luts(cal);
+}
 
-    char line[512];
-    int gain = fallback_gain;
-    while (fgets(line, sizeof(line), f)) {
-        int val = 0;
-        if (sscanf(line, " brake_gain_rpm_per_deg %*[^0-9-]%d", &val) == 1 && val >= 0) {
-            gain = val;
-            break;
+unsigned long long ecu_calib_hash(const ecu_calib_t *cal) {
+    // ecu_calib_defaults() zeroes the struct, so padding hashes stably.
+    const unsigned char *p = (const unsigned char *)cal;
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < offsetof(ecu_calib_t, present); i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Applies one value; returns 0 if the rule rejected it (value ignored).
+static int calib_apply(ecu_calib_t *cal, int idx, const char *val, char **end) {
+    const calib_key_t *k = &CALIB_KEYS[idx];
+    char *base = (char *)cal + k->offset;
+    int seen = (cal->present >> idx) & 1ULL;
+
+    if (k->rule == CK_DBL_RAW || k->rule == CK_DBL_UNIT) {
+        double dv = strtod(val, end);
+        if (*end == val) return 0;
+        if (k->rule == CK_DBL_UNIT) dv = clamp_double(dv, 0.0, 1.0);
+        *(double *)base = dv;
+        return 1;
+    }
+
+    // SCR2's legacy parser skipped every non-digit before the value, its
+    // '-' included: "max_engine_speed = -100" has always meant 100.
+    if (k->rule == CK_INT_POSITIVE_FIRST) {
+        const char *d = val;
+        while (*d && (*d < '0' || *d > '9')) d++;
+        if (*d) val = d;
+    }
+    long lv = strtol(val, end, 10);
+    if (*end == val) return 0;
+    int iv = (int)lv;
+    switch (k->rule) {
+    case CK_INT_POSITIVE_FIRST: if (iv <= 0 || seen) return 0; break;
+    case CK_INT_NONNEG_FIRST:   if (iv <  0 || seen) return 0; break;
+    case CK_INT_CLAMP0:         if (iv < 0) iv = 0; break;
+    case CK_INT_MIN1:           if (iv < 1) iv = 1; break;
+    case CK_INT_BOOL:           iv = iv ? 1 : 0; break;
+    default: break;
+    }
+    *(int *)base = iv;
+    return 1;
+}
+
+// Applies each line of buf (NUL-terminated, edited in place while
+// parsing); name labels the report lines.
+static int calib_parse_buf(char *buf, const char *calib_path, ecu_calib_t *cal, FILE *report) {
+    int applied = 0, lineno = 0;
+    char *p = buf;
+    while (*p) {
+        char *eol = p;
+        while (*eol && *eol != '\n') eol++;
+        char saved = *eol;
+        *eol = '\0';
+        lineno++;
+
+        char *q = p;
+        while (*q == ' ' || *q == '\t' || *q == '\r') q++;
+        if (*q && *q != '#' && *q != ';') {
+            char *key = q;
+            while (is_key_char(*q)) q++;
+            size_t klen = (size_t)(q - key);
+            while (*q == ' ' || *q == '\t' || *q == '=' || *q == ':') q++;
+
+            int idx = klen ? calib_key_index(key, klen) : -1;
+            if (idx < 0) {
+                cal->unknown_keys++;
+                if (report) fprintf(report, "calib: %s:%d: unknown key '%.*s'\n",
+                                    calib_path, lineno, (int)(klen ? klen : strcspn(key, " \t\r=")), key);
+            } else {
+                if ((cal->present >> idx) & 1ULL) {
+                    cal->duplicate_keys++;
+                    if (report) fprintf(report, "calib: %s:%d: duplicate key '%s'\n",
+                                        calib_path, lineno, CALIB_KEYS[idx].name);
+                }
+                char *end;
+                if (calib_apply(cal, idx, q, &end)) {
+                    cal->present |= 1ULL << idx;
+                    cal->key_lines[idx]++;
+                    applied++;
+                } else {
+                    cal->rejected_values++;
+                    if (end == q && report) {
+                        fprintf(report, "calib: %s:%d: missing value for '%s'\n",
+                                calib_path, lineno, CALIB_KEYS[idx].name);
+                    }
+                }
+            }
+        }
+
+        *eol = saved;
+        p = saved ? eol + 1 : eol;
+    }
+
+    return applied;
+}
+
+int ecu_calib_load(const char *calib_path, ecu_calib_t *cal, FILE *report) {
+    ecu_calib_defaults(cal);
+
+    FILE *f = fopen(calib_path, "rb");
+    if (!f) { ecu_calib_prepare(cal); return -1; }
+
+    size_t cap = 4096, len = 0;
+    char *buf = malloc(cap + 1);
+    if (!buf) { fclose(f); ecu_calib_prepare(cal); return -1; }
+    size_t got;
+    while ((got = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += got;
+        if (len == cap) {
+            char *nb = realloc(buf, cap * 2 + 1);
+            if (!nb) break;
+            buf = nb; cap *= 2;
         }
     }
     fclose(f);
-    return gain;
+    buf[len] = '\0';
+
+    int applied = calib_parse_buf(buf, calib_path, cal, report);
+    free(buf);
+    ecu_calib_prepare(cal);
+    return applied;
 }
 
-// ======================== SCR4 ==============================
-int parse_gear_multipliers(const char *calib_path, double gear_mult[6]) {
-    // defaults
-    gear_mult[0] = 0.0;   // unused
-    gear_mult[1] = 0.60;
-    gear_mult[2] = 0.85;
-    gear_mult[3] = 1.00;
-    gear_mult[4] = 1.10;
-    gear_mult[5] = 1.20;
+int ecu_calib_parse(const char *text, const char *name, ecu_calib_t *cal, FILE *report) {
+    ecu_calib_defaults(cal);
+    size_t len = strlen(text);
+    char *buf = malloc(len + 1);
+    if (!buf) return -1;
+    memcpy(buf, text, len + 1);
+    int applied = calib_parse_buf(buf, name ? name : "<text>", cal, report);
+    free(buf);
+    ecu_calib_prepare(cal);
+    return applied;
+}
 
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
+int ecu_calib_has(const ecu_calib_t *cal, const char *key) {
+    int idx = calib_key_index(key, strlen(key));
+    return idx >= 0 && ((cal->present >> idx) & 1ULL);
+}
 
-    int parsed = 0;
-    char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        double v;
-        if (sscanf(line, " gear_acc_multiplier_g1 %*[^0-9.-]%lf", &v) == 1) { gear_mult[1] = v; parsed++; continue; }
-        if (sscanf(line, " gear_acc_multiplier_g2 %*[^0-9.-]%lf", &v) == 1) { gear_mult[2] = v; parsed++; continue; }
-        if (sscanf(line, " gear_acc_multiplier_g3 %*[^0-9.-]%lf", &v) == 1) { gear_mult[3] = v; parsed++; continue; }
-        if (sscanf(line, " gear_acc_multiplier_g4 %*[^0-9.-]%lf", &v) == 1) { gear_mult[4] = v; parsed++; continue; }
-        if (sscanf(line, " gear_acc_multiplier_g5 %*[^0-9.-]%lf", &v) == 1) { gear_mult[5] = v; parsed++; continue; }
+// Lines that set key: what the legacy parse_* functions counted, one per
+// matching line, duplicates included.
+static int calib_lines(const ecu_calib_t *cal, const char *key) {
+    int idx = calib_key_index(key, strlen(key));
+    return idx >= 0 ? cal->key_lines[idx] : 0;
+}
+
+int ecu_calib_set(ecu_calib_t *cal, const char *key, const char *value) {
+    int idx = calib_key_index(key, strlen(key));
+    if (idx < 0) return -1;
+
+    unsigned long long bit = 1ULL << idx;
+    unsigned long long was = cal->present & bit;
+    cal->present &= ~bit;     // an explicit set overrides first-wins keys too
+    char *end;
+    if (!calib_apply(cal, idx, value, &end)) {
+        cal->present |= was;
+        return -1;
     }
-    fclose(f);
-    return parsed;
+    cal->present |= bit;
+    ecu_calib_prepare(cal);
+    return 0;
+}
+
+// ======================== SCR1 ==============================
+int compute_engine_state(int ignition_switch) {
+    return ignition_switch ? 1 : 0;
+}
+
+// ======================== SCR2 ==============================
+int parse_max_engine_speed(const char *calib_path, int fallback_rpm) {
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
+    return ecu_calib_has(&cal, "max_engine_speed") ? cal.max_engine_speed : fallback_rpm;
+}
+
+// ======================== SCR3 ==============================
+int parse_brake_gain(const char *calib_path, int fallback_gain) {
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
+    return ecu_calib_has(&cal, "brake_gain_rpm_per_deg") ? cal.brake_gain_rpm_per_deg : fallback_gain;
+}
+
+// ======================== SCR4 ==============================
+int parse_gear_multipliers(const char *calib_path, double gear_mult[6]) {
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
+    memcpy(gear_mult, cal.gear_mult, sizeof(cal.gear_mult));
+    return calib_lines(&cal, "gear_acc_multiplier_g1") + calib_lines(&cal, "gear_acc_multiplier_g2") +
+           calib_lines(&cal, "gear_acc_multiplier_g3") + calib_lines(&cal, "gear_acc_multiplier_g4") +
+           calib_lines(&cal, "gear_acc_multiplier_g5");
 }
 
 int update_engine_speed(int engine_state,
@@ -122,27 +490,15 @@ int parse_cc_params(const char *calib_path,
                     int *cc_target_min,
                     int *cc_target_max)
 {
-    // defaults
-    if (cc_kp)                  *cc_kp = 0.2;
-    if (cc_max_step_per_iter)   *cc_max_step_per_iter = 30;
-    if (cc_activation_gear_min) *cc_activation_gear_min = 3;
-    if (cc_target_min)          *cc_target_min = 300;
-    if (cc_target_max)          *cc_target_max = 2000;
-
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
     int parsed = 0;
-    char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        double dv; int iv;
-        if (cc_kp && sscanf(line, " cc_kp %*[^0-9.-]%lf", &dv) == 1) { *cc_kp = dv; parsed++; continue; }
-        if (cc_max_step_per_iter && sscanf(line, " cc_max_step_per_iter %*[^0-9-]%d", &iv) == 1) { *cc_max_step_per_iter = iv; parsed++; continue; }
-        if (cc_activation_gear_min && sscanf(line, " cc_activation_gear_min %*[^0-9-]%d", &iv) == 1) { *cc_activation_gear_min = iv; parsed++; continue; }
-        if (cc_target_min && sscanf(line, " cc_target_min %*[^0-9-]%d", &iv) == 1) { *cc_target_min = iv; parsed++; continue; }
-        if (cc_target_max && sscanf(line, " cc_target_max %*[^0-9-]%d", &iv) == 1) { *cc_target_max = iv; parsed++; continue; }
-    }
-    fclose(f);
+    if (cc_kp)                  { *cc_kp = cal.cc_kp;                                   parsed += calib_lines(&cal, "cc_kp"); }
+    if (cc_max_step_per_iter)   { *cc_max_step_per_iter = cal.cc_max_step_per_iter;     parsed += calib_lines(&cal, "cc_max_step_per_iter"); }
+    if (cc_activation_gear_min) { *cc_activation_gear_min = cal.cc_activation_gear_min; parsed += calib_lines(&cal, "cc_activation_gear_min"); }
+    if (cc_target_min)          { *cc_target_min = cal.cc_target_min;                   parsed += calib_lines(&cal, "cc_target_min"); }
+    if (cc_target_max)          { *cc_target_max = cal.cc_target_max;                   parsed += calib_lines(&cal, "cc_target_max"); }
     return parsed;
 }
 
@@ -197,20 +553,9 @@ int update_engine_speed_cc(int engine_state,
 
 // ======================== SCR6 ==============================
 int parse_drag_rpm_per_iter(const char *calib_path, int fallback_drag) {
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return fallback_drag;
-
-    char line[512];
-    int drag = fallback_drag;
-    while (fgets(line, sizeof(line), f)) {
-        int val = 0;
-        if (sscanf(line, " drag_rpm_per_iter %*[^0-9-]%d", &val) == 1 && val >= 0) {
-            drag = val;
-            break;
-        }
-    }
-    fclose(f);
-    return drag;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
+    return ecu_calib_has(&cal, "drag_rpm_per_iter") ? cal.drag_rpm_per_iter : fallback_drag;
 }
 
 int update_engine_speed_cc_drag(int engine_state,
@@ -260,25 +605,14 @@ int parse_idle_params(const char *calib_path,
                       int *idle_max_step_per_iter,
                       int *idle_activation_gear_max)
 {
-    // defaults
-    if (idle_target_speed)        *idle_target_speed = 600;
-    if (idle_kp)                  *idle_kp = 0.2;
-    if (idle_max_step_per_iter)   *idle_max_step_per_iter = 15;
-    if (idle_activation_gear_max) *idle_activation_gear_max = 5;
-
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
     int parsed = 0;
-    char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        double dv; int iv;
-        if (idle_target_speed && sscanf(line, " idle_target_speed %*[^0-9-]%d", &iv) == 1) { *idle_target_speed = iv; parsed++; continue; }
-        if (idle_kp && sscanf(line, " idle_kp %*[^0-9.-]%lf", &dv) == 1) { *idle_kp = dv; parsed++; continue; }
-        if (idle_max_step_per_iter && sscanf(line, " idle_max_step_per_iter %*[^0-9-]%d", &iv) == 1) { *idle_max_step_per_iter = iv; parsed++; continue; }
-        if (idle_activation_gear_max && sscanf(line, " idle_activation_gear_max %*[^0-9-]%d", &iv) == 1) { *idle_activation_gear_max = iv; parsed++; continue; }
-    }
-    fclose(f);
+    if (idle_target_speed)        { *idle_target_speed = cal.idle_target_speed;               parsed += calib_lines(&cal, "idle_target_speed"); }
+    if (idle_kp)                  { *idle_kp = cal.idle_kp;                                   parsed += calib_lines(&cal, "idle_kp"); }
+    if (idle_max_step_per_iter)   { *idle_max_step_per_iter = cal.idle_max_step_per_iter;     parsed += calib_lines(&cal, "idle_max_step_per_iter"); }
+    if (idle_activation_gear_max) { *idle_activation_gear_max = cal.idle_activation_gear_max; parsed += calib_lines(&cal, "idle_activation_gear_max"); }
     return parsed;
 }
 
@@ -345,27 +679,12 @@ int parse_slew_params(const char *calib_path,
                       int *slew_max_rise_per_iter,
                       int *slew_max_fall_per_iter)
 {
-    // defaults
-    if (slew_max_rise_per_iter) *slew_max_rise_per_iter = 50;
-    if (slew_max_fall_per_iter) *slew_max_fall_per_iter = 80;
-
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
     int parsed = 0;
-    char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        int iv;
-        if (slew_max_rise_per_iter &&
-            sscanf(line, " slew_max_rise_per_iter %*[^0-9-]%d", &iv) == 1) {
-            *slew_max_rise_per_iter = (iv < 0) ? 0 : iv; parsed++; continue;
-        }
-        if (slew_max_fall_per_iter &&
-            sscanf(line, " slew_max_fall_per_iter %*[^0-9-]%d", &iv) == 1) {
-            *slew_max_fall_per_iter = (iv < 0) ? 0 : iv; parsed++; continue;
-        }
-    }
-    fclose(f);
+    if (slew_max_rise_per_iter) { *slew_max_rise_per_iter = cal.slew_max_rise_per_iter; parsed += calib_lines(&cal, "slew_max_rise_per_iter"); }
+    if (slew_max_fall_per_iter) { *slew_max_fall_per_iter = cal.slew_max_fall_per_iter; parsed += calib_lines(&cal, "slew_max_fall_per_iter"); }
     return parsed;
 }
 
@@ -406,40 +725,16 @@ int parse_limp_params(const char *calib_path,
                       double *limp_acc_gain_scale,
                       int *limp_clear_on_ignition_off)
 {
-    // defaults
-    if (acc_overlap_deg)            *acc_overlap_deg = 10;
-    if (brk_overlap_deg)            *brk_overlap_deg = 10;
-    if (limp_rows_confirm)          *limp_rows_confirm = 2;
-    if (limp_max_speed)             *limp_max_speed = 300;
-    if (limp_acc_gain_scale)        *limp_acc_gain_scale = 0.3;
-    if (limp_clear_on_ignition_off) *limp_clear_on_ignition_off = 1;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
-
-    int parsed = 0; char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        int iv; double dv;
-        if (acc_overlap_deg && sscanf(line, " acc_overlap_deg %*[^0-9-]%d", &iv) == 1) { *acc_overlap_deg = (iv<0?0:iv); parsed++; continue; }
-        if (brk_overlap_deg && sscanf(line, " brk_overlap_deg %*[^0-9-]%d", &iv) == 1) { *brk_overlap_deg = (iv<0?0:iv); parsed++; continue; }
-        if (limp_rows_confirm && sscanf(line, " limp_rows_confirm %*[^0-9-]%d", &iv) == 1) { *limp_rows_confirm = (iv<1?1:iv); parsed++; continue; }
-        if (limp_max_speed && sscanf(line, " limp_max_speed %*[^0-9-]%d", &iv) == 1) { *limp_max_speed = (iv<0?0:iv); parsed++; continue; }
-        if (limp_acc_gain_scale &&
-            sscanf(line, " limp_acc_gain_scale %*[^0-9.-]%lf", &dv) == 1) {
-            if (dv < 0.0) dv = 0.0;
-            if (dv > 1.0) dv = 1.0;
-            *limp_acc_gain_scale = dv;
-            parsed++;
-            continue;
-        }
-        if (limp_clear_on_ignition_off &&
-            sscanf(line, " limp_clear_on_ignition_off %*[^0-9-]%d", &iv) == 1) {
-            *limp_clear_on_ignition_off = (iv ? 1 : 0);
-            parsed++;
-            continue;
-        }
-    }
-    fclose(f);
+    int parsed = 0;
+    if (acc_overlap_deg)            { *acc_overlap_deg = cal.acc_overlap_deg;                       parsed += calib_lines(&cal, "acc_overlap_deg"); }
+    if (brk_overlap_deg)            { *brk_overlap_deg = cal.brk_overlap_deg;                       parsed += calib_lines(&cal, "brk_overlap_deg"); }
+    if (limp_rows_confirm)          { *limp_rows_confirm = cal.limp_rows_confirm;                   parsed += calib_lines(&cal, "limp_rows_confirm"); }
+    if (limp_max_speed)             { *limp_max_speed = cal.limp_max_speed;                         parsed += calib_lines(&cal, "limp_max_speed"); }
+    if (limp_acc_gain_scale)        { *limp_acc_gain_scale = cal.limp_acc_gain_scale;               parsed += calib_lines(&cal, "limp_acc_gain_scale"); }
+    if (limp_clear_on_ignition_off) { *limp_clear_on_ignition_off = cal.limp_clear_on_ignition_off; parsed += calib_lines(&cal, "limp_clear_on_ignition_off"); }
     return parsed;
 }
 
@@ -502,26 +797,15 @@ int parse_rev_params(const char *calib_path,
                      int *rev_hard_cut_step,
                      int *rev_cut_cooldown_rows)
 {
-    // defaults
-    if (rev_soft_limit)         *rev_soft_limit = 1800;
-    if (rev_hard_limit)         *rev_hard_limit = 1950;
-    if (rev_hysteresis)         *rev_hysteresis = 50;
-    if (rev_hard_cut_step)      *rev_hard_cut_step = 60;
-    if (rev_cut_cooldown_rows)  *rev_cut_cooldown_rows = 2;
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
-
-    int parsed = 0; char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        int iv;
-        if (rev_soft_limit && sscanf(line, " rev_soft_limit %*[^0-9-]%d", &iv) == 1) { *rev_soft_limit = (iv<0?0:iv); parsed++; continue; }
-        if (rev_hard_limit && sscanf(line, " rev_hard_limit %*[^0-9-]%d", &iv) == 1) { *rev_hard_limit = (iv<0?0:iv); parsed++; continue; }
-        if (rev_hysteresis && sscanf(line, " rev_hysteresis %*[^0-9-]%d", &iv) == 1) { *rev_hysteresis = (iv<0?0:iv); parsed++; continue; }
-        if (rev_hard_cut_step && sscanf(line, " rev_hard_cut_step %*[^0-9-]%d", &iv) == 1) { *rev_hard_cut_step = (iv<0?0:iv); parsed++; continue; }
-        if (rev_cut_cooldown_rows && sscanf(line, " rev_cut_cooldown_rows %*[^0-9-]%d", &iv) == 1) { *rev_cut_cooldown_rows = (iv<0?0:iv); parsed++; continue; }
-    }
-    fclose(f);
+    int parsed = 0;
+    if (rev_soft_limit)        { *rev_soft_limit = cal.rev_soft_limit;               parsed += calib_lines(&cal, "rev_soft_limit"); }
+    if (rev_hard_limit)        { *rev_hard_limit = cal.rev_hard_limit;               parsed += calib_lines(&cal, "rev_hard_limit"); }
+    if (rev_hysteresis)        { *rev_hysteresis = cal.rev_hysteresis;               parsed += calib_lines(&cal, "rev_hysteresis"); }
+    if (rev_hard_cut_step)     { *rev_hard_cut_step = cal.rev_hard_cut_step;         parsed += calib_lines(&cal, "rev_hard_cut_step"); }
+    if (rev_cut_cooldown_rows) { *rev_cut_cooldown_rows = cal.rev_cut_cooldown_rows; parsed += calib_lines(&cal, "rev_cut_cooldown_rows"); }
     return parsed;
 }
 
@@ -600,35 +884,13 @@ int parse_bto_params(const char *calib_path,
                      int *bto_acc_min_deg,
                      double *bto_acc_scale)
 {
-    if (bto_brake_deg)   *bto_brake_deg   = 10;
-    if (bto_acc_min_deg) *bto_acc_min_deg = 5;
-    if (bto_acc_scale)   *bto_acc_scale   = 0.0; // full cut by default
-
-    FILE *f = fopen(calib_path, "r");
-    if (!f) return 0;
-
-    int parsed = 0; char line[512];
-    while (fgets(line, sizeof(line), f)) {
-        int iv; double dv;
-        if (bto_brake_deg && sscanf(line, " bto_brake_deg %*[^0-9-]%d", &iv) == 1) {
-            *bto_brake_deg = (iv < 0 ? 0 : iv); parsed++; continue;
-        }
-        if (bto_acc_min_deg && sscanf(line, " bto_acc_min_deg %*[^0-9-]%d", &iv) == 1) {
-            *bto_acc_min_deg = (iv < 0 ? 0 : iv); parsed++; continue;
-        }
-if (bto_acc_scale && sscanf(line, " bto_acc_scale %*[^0-9.-]%lf", &dv) == 1) {
-    if (dv < 0.0) {
-        dv = 0.0;
-    } else if (dv > 1.0) {
-        dv = 1.0;
-    }
-    *bto_acc_scale = dv;
-    parsed++;
-    continue;
-}
+    ecu_calib_t cal;
+    ecu_calib_load(calib_path, &cal, NULL);
 
-    }
-    fclose(f);
+    int parsed = 0;
+    if (bto_brake_deg)   { *bto_brake_deg = cal.bto_brake_deg;     parsed += calib_lines(&cal, "bto_brake_deg"); }
+    if (bto_acc_min_deg) { *bto_acc_min_deg = cal.bto_acc_min_deg; parsed += calib_lines(&cal, "bto_acc_min_deg"); }
+    if (bto_acc_scale)   { *bto_acc_scale = cal.bto_acc_scale;     parsed += calib_lines(&cal, "bto_acc_scale"); }
     return parsed;
 }
 
@@ -659,6 +921,444 @@ return e;
     return acc;
 }
 
+// ==================== Fused step (SCR1..SCR11) ==============
+void ecu_state_init(ecu_state_t *st) {
+    memset(st, 0, sizeof(*st));
+}
+
+static inline int step_row(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in) {
+    const int max = cal->max_engine_speed;
+    PROF_ROW_BEGIN();
+
+    // SCR1 + ignition OFF resets (SCR9 latch if configured, SCR10 latch)
+    if (!in->ignition_switch) {
+        if (cal->limp_clear_on_ignition_off) {
+            st->limp_mode = 0;
+            st->overlap_run_count = 0;
+        }
+        st->hard_cut_active   = 0;
+        st->hard_cut_cooldown = 0;
+        st->engine_state = 0;
+        st->engine_speed = 0;
+        PROF_LAP(PROF_IGNITION);
+        return 0;
+    }
+    st->engine_state = 1;
+
+    // Every clamp, once
+    const int acc   = clamp_int(in->acc_pedal_position,   0, 45);
+    const int brake = clamp_int(in->brake_pedal_position, 0, 45);
+    const int gear  = clamp_int(in->current_gear, 1, 5);
+    const int prev_raw = st->engine_speed;
+    const int prev  = prev_raw < 0 ? 0 : prev_raw;
+    PROF_LAP(PROF_IGNITION);
+
+    // SCR9: plausibility on raw pedals
+    if (acc >= cal->run.acc_overlap && brake >= cal->run.brk_overlap) st->overlap_run_count++;
+    else                                                              st->overlap_run_count = 0;
+    if (st->overlap_run_count >= cal->run.limp_need) st->limp_mode = 1;
+    PROF_LAP(PROF_LIMP);
+
+    // SCR11: effective accelerator
+    const int eff = cal->run.bto_eff[brake][acc];
+    PROF_LAP(PROF_BTO);
+
+    int speed;
+    if (in->cruise_enable == 1 && brake == 0 && eff == 0 && gear >= cal->cc_activation_gear_min) {
+        // SCR2..SCR4 baseline + SCR5 cruise
+        double next = (double)prev + (double)eff * cal->run.acc_gain[gear]
+                                   - (double)brake * (double)cal->brake_gain_rpm_per_deg;
+        int target = clamp_int(in->cruise_target_speed, cal->cc_target_min, cal->run.cc_target_hi);
+        double delta_cc = cal->cc_kp * ((double)target - (double)prev);
+        if (delta_cc > (double)cal->cc_max_step_per_iter)    delta_cc = (double)cal->cc_max_step_per_iter;
+        if (delta_cc < (double)(-cal->cc_max_step_per_iter)) delta_cc = (double)(-cal->cc_max_step_per_iter);
+        next += delta_cc;
+        speed = round_to_int(clamp_double(next, 0.0, (double)max));
+    } else if (cal->run.acc_lut[gear][eff] != LUT_DOUBLE) {
+        // SCR2..SCR4 baseline from the tables
+        speed = clamp_int(prev + cal->run.acc_lut[gear][eff] - cal->run.brake_lut[brake], 0, max);
+    } else {
+        double next = (double)prev + (double)eff * cal->run.acc_gain[gear]
+                                   - (double)brake * (double)cal->brake_gain_rpm_per_deg;
+        speed = round_to_int(clamp_double(next, 0.0, (double)max));
+    }
+
+    if (eff == 0 && brake == 0 && in->cruise_enable == 0) {
+        // SCR6 coastdown
+        speed = clamp_int(speed - cal->run.drag, 0, max);
+
+        // SCR7 idle
+        if (gear <= cal->idle_activation_gear_max && prev_raw < cal->idle_target_speed) {
+            double delta_idle = cal->idle_kp * (double)(cal->idle_target_speed - prev);
+            if (delta_idle < 0.0) delta_idle = 0.0;
+            if (delta_idle > (double)cal->idle_max_step_per_iter) delta_idle = (double)cal->idle_max_step_per_iter;
+            speed = clamp_int(speed + round_to_int(delta_idle), 0, max);
+        }
+    }
+    PROF_LAP(PROF_SPEED);
+
+    // SCR9 limp cap
+    if (st->limp_mode && speed > cal->run.limp_cap) speed = cal->run.limp_cap;
+    PROF_LAP(PROF_LIMP_CAP);
+
+    // SCR10 rev limiter
+    if (st->hard_cut_active) {
+        int pull = prev - cal->run.rev_cut_step;
+        if (speed > pull) speed = pull;
+        if (st->hard_cut_cooldown > 0) st->hard_cut_cooldown--;
+        if (prev <= cal->run.rev_hard - cal->run.rev_hysteresis && st->hard_cut_cooldown == 0) {
+            st->hard_cut_active = 0;
+        }
+    } else if (speed > cal->run.rev_hard || prev > cal->run.rev_hard) {
+        st->hard_cut_active   = 1;
+        st->hard_cut_cooldown = cal->run.rev_cooldown;
+        if (speed > cal->run.rev_hard) speed = cal->run.rev_hard;
+    }
+    if (speed > cal->run.rev_soft) speed = cal->run.rev_soft;
+    speed = clamp_int(speed, 0, max);
+    PROF_LAP(PROF_REV);
+
+    // SCR8 slew vs previous output
+    if (speed - prev > cal->run.slew_rise)        speed = prev + cal->run.slew_rise;
+    else if (speed - prev < -cal->run.slew_fall)  speed = prev - cal->run.slew_fall;
+    speed = clamp_int(speed, 0, max);
+    PROF_LAP(PROF_SLEW);
+
+    st->engine_speed = speed;
+    return speed;
+}
+
+// ==================== Fixed-point step (Q ECU_Q_BITS) =======
+// step_row() with each double expression replaced by its Q equivalent;
+// the integer stages are unchanged.
+static inline int step_row_q(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in) {
+    const int max = cal->max_engine_speed;
+    PROF_ROW_BEGIN();
+
+    if (!in->ignition_switch) {
+        if (cal->limp_clear_on_ignition_off) {
+            st->limp_mode = 0;
+            st->overlap_run_count = 0;
+        }
+        st->hard_cut_active   = 0;
+        st->hard_cut_cooldown = 0;
+        st->engine_state = 0;
+        st->engine_speed = 0;
+        PROF_LAP(PROF_IGNITION);
+        return 0;
+    }
+    st->engine_state = 1;
+
+    const int acc   = clamp_int(in->acc_pedal_position,   0, 45);
+    const int brake = clamp_int(in->brake_pedal_position, 0, 45);
+    const int gear  = clamp_int(in->current_gear, 1, 5);
+    const int prev_raw = st->engine_speed;
+    const int prev  = prev_raw < 0 ? 0 : prev_raw;
+    PROF_LAP(PROF_IGNITION);
+
+    // SCR9
+    if (acc >= cal->run.acc_overlap && brake >= cal->run.brk_overlap) st->overlap_run_count++;
+    else                                                              st->overlap_run_count = 0;
+    if (st->overlap_run_count >= cal->run.limp_need) st->limp_mode = 1;
+    PROF_LAP(PROF_LIMP);
+
+    // SCR11
+    // The table holds whole degrees, so a .5 tie in acc * bto_acc_scale
+    // rounds as in ecu_step() instead of being multiplied by the gear gain.
+    const int eff = cal->run.bto_eff[brake][acc];
+    PROF_LAP(PROF_BTO);
+
+    // SCR2..SCR4
+    long long next = int_q(prev) + (long long)eff * cal->run.acc_gain_q[gear]
+                                 - int_q(brake) * cal->brake_gain_rpm_per_deg;
+
+    // SCR5
+    if (in->cruise_enable == 1 && brake == 0 && eff == 0 && gear >= cal->cc_activation_gear_min) {
+        int target = clamp_int(in->cruise_target_speed, cal->cc_target_min, cal->run.cc_target_hi);
+        long long step = int_q(cal->cc_max_step_per_iter);
+        long long delta_cc = cal->run.cc_kp_q * (long long)(target - prev);
+        // Upper limit first, as ecu_step(): a negative step swaps the bounds.
+        if (delta_cc > step)  delta_cc = step;
+        if (delta_cc < -step) delta_cc = -step;
+        next += delta_cc;
+    }
+    int speed = q_round(clamp_q(next, 0, int_q(max)));
+
+    if (eff == 0 && brake == 0 && in->cruise_enable == 0) {
+        // SCR6
+        speed = clamp_int(speed - cal->run.drag, 0, max);
+
+        // SCR7
+        if (gear <= cal->idle_activation_gear_max && prev_raw < cal->idle_target_speed) {
+            long long delta_idle = cal->run.idle_kp_q * (long long)(cal->idle_target_speed - prev);
+            if (delta_idle < 0) delta_idle = 0;
+            if (delta_idle > int_q(cal->idle_max_step_per_iter)) delta_idle = int_q(cal->idle_max_step_per_iter);
+            speed = clamp_int(speed + q_round(delta_idle), 0, max);
+        }
+    }
+    PROF_LAP(PROF_SPEED);
+
+    // SCR9 limp cap
+    if (st->limp_mode && speed > cal->run.limp_cap) speed = cal->run.limp_cap;
+    PROF_LAP(PROF_LIMP_CAP);
+
+    // SCR10
+    if (st->hard_cut_active) {
+        int pull = prev - cal->run.rev_cut_step;
+        if (speed > pull) speed = pull;
+        if (st->hard_cut_cooldown > 0) st->hard_cut_cooldown--;
+        if (prev <= cal->run.rev_hard - cal->run.rev_hysteresis && st->hard_cut_cooldown == 0) {
+            st->hard_cut_active = 0;
+        }
+    } else if (speed > cal->run.rev_hard || prev > cal->run.rev_hard) {
+        st->hard_cut_active   = 1;
+        st->hard_cut_cooldown = cal->run.rev_cooldown;
+        if (speed > cal->run.rev_hard) speed = cal->run.rev_hard;
+    }
+    if (speed > cal->run.rev_soft) speed = cal->run.rev_soft;
+    speed = clamp_int(speed, 0, max);
+    PROF_LAP(PROF_REV);
+
+    // SCR8
+    if (speed - prev > cal->run.slew_rise)        speed = prev + cal->run.slew_rise;
+    else if (speed - prev < -cal->run.slew_fall)  speed = prev - cal->run.slew_fall;
+    speed = clamp_int(speed, 0, max);
+    PROF_LAP(PROF_SLEW);
+
+    st->engine_speed = speed;
+    return speed;
+}
+
+// -DECU_FIXED_POINT: the public step and batch run on the Q kernel.
+#ifdef ECU_FIXED_POINT
+#define STEP_ROW step_row_q
+#else
+#define STEP_ROW step_row
+#endif
+
+int ecu_step(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in) {
+    return STEP_ROW(cal, st, in);
+}
+
+int ecu_step_q(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in) {
+    return step_row_q(cal, st, in);
+}
+
+// ==================== Batch (structure of arrays) ===========
+#define RUN_BATCH_BODY(step)                                        \
+    ecu_state_t s = *st;   /* keep the latches in registers */     \
+    for (size_t i = 0; i < n; i++) {                                \
+        ecu_input_t row = {                                         \
+            in->ignition_switch[i],                                 \
+            in->acc_pedal_position[i],                              \
+            in->brake_pedal_position[i],                            \
+            in->current_gear[i],                                    \
+            in->cruise_enable[i],                                   \
+            in->cruise_target_speed[i]                              \
+        };                                                          \
+        engine_speed[i] = step(cal, &s, &row);                      \
+        engine_state[i] = s.engine_state;                           \
+    }                                                               \
+    *st = s;
+
+void ecu_run_batch(const ecu_calib_t *cal,
+                   ecu_state_t *st,
+                   const ecu_columns_t *in,
+                   size_t n,
+                   int *engine_state,
+                   int *engine_speed)
+{
+    RUN_BATCH_BODY(STEP_ROW)
+}
+
+void ecu_run_batch_q(const ecu_calib_t *cal,
+                     ecu_state_t *st,
+                     const ecu_columns_t *in,
+                     size_t n,
+                     int *engine_state,
+                     int *engine_speed)
+{
+    RUN_BATCH_BODY(step_row_q)
+}
+
+// ==================== Sensitivities (dual numbers) ===========
+// step_row() with a tangent vector beside every double/int value that
+// depends on a calibration double. Branch conditions use the values only,
+// so the result matches step_row() exactly.
+const char *const ECU_SENS_KEY[ECU_NSENS] = {
+    "cc_kp", "idle_kp",
+    "gear_acc_multiplier_g1", "gear_acc_multiplier_g2", "gear_acc_multiplier_g3",
+    "gear_acc_multiplier_g4", "gear_acc_multiplier_g5",
+    "bto_acc_scale"
+};
+
+static void tangent_zero(double d[ECU_NSENS]) {
+    for (int k = 0; k < ECU_NSENS; k++) d[k] = 0.0;
+}
+
+static void tangent_copy(double d[ECU_NSENS], const double s[ECU_NSENS]) {
+    for (int k = 0; k < ECU_NSENS; k++) d[k] = s[k];
+}
+
+int ecu_step_sens(const ecu_calib_t *cal, ecu_state_t *st, ecu_sens_t *sens, const ecu_input_t *in) {
+    const int max = cal->max_engine_speed;
+    double *ds = sens->d_speed;
+
+    if (!in->ignition_switch) {
+        if (cal->limp_clear_on_ignition_off) {
+            st->limp_mode = 0;
+            st->overlap_run_count = 0;
+        }
+        st->hard_cut_active   = 0;
+        st->hard_cut_cooldown = 0;
+        st->engine_state = 0;
+        st->engine_speed = 0;
+        tangent_zero(ds);
+        return 0;
+    }
+    st->engine_state = 1;
+
+    const int acc   = clamp_int(in->acc_pedal_position,   0, 45);
+    const int brake = clamp_int(in->brake_pedal_position, 0, 45);
+    const int gear  = clamp_int(in->current_gear, 1, 5);
+    const int prev_raw = st->engine_speed;
+    const int prev  = prev_raw < 0 ? 0 : prev_raw;
+    double dprev[ECU_NSENS];
+    if (prev_raw < 0) tangent_zero(dprev);
+    else              tangent_copy(dprev, ds);
+
+    if (acc >= cal->run.acc_overlap && brake >= cal->run.brk_overlap) st->overlap_run_count++;
+    else                                                              st->overlap_run_count = 0;
+    if (st->overlap_run_count >= cal->run.limp_need) st->limp_mode = 1;
+
+    // SCR11: d eff / d bto_acc_scale = acc inside both clamps
+    int eff = acc;
+    double d_eff_scale = 0.0;
+    if (brake >= cal->run.bto_brake && acc >= cal->run.bto_acc_min) {
+        int r = round_to_int((double)acc * cal->run.bto_scale);
+        eff = clamp_int(r, 0, 45);
+        if (r == eff && cal->bto_acc_scale >= 0.0 && cal->bto_acc_scale <= 1.0) d_eff_scale = (double)acc;
+    }
+
+    // SCR2..SCR4
+    double next = (double)prev + (double)eff * cal->run.acc_gain[gear]
+                               - (double)brake * (double)cal->brake_gain_rpm_per_deg;
+    double dn[ECU_NSENS];
+    tangent_copy(dn, dprev);
+    dn[ECU_SENS_BTO_ACC_SCALE] += d_eff_scale * cal->run.acc_gain[gear];
+    dn[ECU_SENS_GEAR_G1 + gear - 1] += (double)eff * ACC_BASE_GAIN_RPM_PER_DEG;
+
+    // SCR5
+    if (in->cruise_enable == 1 && brake == 0 && eff == 0 && gear >= cal->cc_activation_gear_min) {
+        int target = clamp_int(in->cruise_target_speed, cal->cc_target_min, cal->run.cc_target_hi);
+        double delta_cc = cal->cc_kp * ((double)target - (double)prev);
+        int limited = 0;
+        if (delta_cc > (double)cal->cc_max_step_per_iter)    { delta_cc = (double)cal->cc_max_step_per_iter; limited = 1; }
+        if (delta_cc < (double)(-cal->cc_max_step_per_iter)) { delta_cc = (double)(-cal->cc_max_step_per_iter); limited = 1; }
+        next += delta_cc;
+        if (!limited) {
+            for (int k = 0; k < ECU_NSENS; k++) dn[k] -= cal->cc_kp * dprev[k];
+            dn[ECU_SENS_CC_KP] += (double)target - (double)prev;
+        }
+    }
+    if (next < 0.0 || next > (double)max) tangent_zero(dn);
+    int speed = round_to_int(clamp_double(next, 0.0, (double)max));
+    tangent_copy(ds, dn);
+
+    if (eff == 0 && brake == 0 && in->cruise_enable == 0) {
+        // SCR6
+        int coast = speed - cal->run.drag;
+        speed = clamp_int(coast, 0, max);
+        if (speed != coast) tangent_zero(ds);
+
+        // SCR7
+        if (gear <= cal->idle_activation_gear_max && prev_raw < cal->idle_target_speed) {
+            double delta_idle = cal->idle_kp * (double)(cal->idle_target_speed - prev);
+            int limited = 0;
+            if (delta_idle < 0.0) { delta_idle = 0.0; limited = 1; }
+            if (delta_idle > (double)cal->idle_max_step_per_iter) { delta_idle = (double)cal->idle_max_step_per_iter; limited = 1; }
+            int raised = speed + round_to_int(delta_idle);
+            speed = clamp_int(raised, 0, max);
+            if (speed != raised) {
+                tangent_zero(ds);
+            } else if (!limited) {
+                for (int k = 0; k < ECU_NSENS; k++) ds[k] -= cal->idle_kp * dprev[k];
+                ds[ECU_SENS_IDLE_KP] += (double)(cal->idle_target_speed - prev);
+            }
+        }
+    }
+
+    // SCR9 limp cap
+    if (st->limp_mode && speed > cal->run.limp_cap) { speed = cal->run.limp_cap; tangent_zero(ds); }
+
+    // SCR10
+    if (st->hard_cut_active) {
+        int pull = prev - cal->run.rev_cut_step;
+        if (speed > pull) { speed = pull; tangent_copy(ds, dprev); }
+        if (st->hard_cut_cooldown > 0) st->hard_cut_cooldown--;
+        if (prev <= cal->run.rev_hard - cal->run.rev_hysteresis && st->hard_cut_cooldown == 0) {
+            st->hard_cut_active = 0;
+        }
+    } else if (speed > cal->run.rev_hard || prev > cal->run.rev_hard) {
+        st->hard_cut_active   = 1;
+        st->hard_cut_cooldown = cal->run.rev_cooldown;
+        if (speed > cal->run.rev_hard) { speed = cal->run.rev_hard; tangent_zero(ds); }
+    }
+    if (speed > cal->run.rev_soft) { speed = cal->run.rev_soft; tangent_zero(ds); }
+    if (speed < 0 || speed > max) { speed = clamp_int(speed, 0, max); tangent_zero(ds); }
+
+    // SCR8
+    if (speed - prev > cal->run.slew_rise)        { speed = prev + cal->run.slew_rise; tangent_copy(ds, dprev); }
+    else if (speed - prev < -cal->run.slew_fall)  { speed = prev - cal->run.slew_fall; tangent_copy(ds, dprev); }
+    if (speed < 0 || speed > max) { speed = clamp_int(speed, 0, max); tangent_zero(ds); }
+
+    st->engine_speed = speed;
+    return speed;
+}
+
+// ==================== Runs of identical rows ================
+// a -> b was one step on a constant input. Every later step repeats it
+// when nothing changed, or when only the overlap count grew past
+// limp_need: from there on it is only compared against limp_need.
+static int state_settled(const ecu_calib_t *cal, const ecu_state_t *a, const ecu_state_t *b) {
+    if (a->engine_speed != b->engine_speed || a->engine_state != b->engine_state ||
+        a->limp_mode != b->limp_mode || a->hard_cut_active != b->hard_cut_active ||
+        a->hard_cut_cooldown != b->hard_cut_cooldown) return 0;
+    if (a->overlap_run_count == b->overlap_run_count) return 1;
+    return b->overlap_run_count == a->overlap_run_count + 1 &&
+           a->overlap_run_count >= cal->run.limp_need;
+}
+
+long long ecu_run_constant(const ecu_calib_t *cal,
+                           ecu_state_t *st,
+                           const ecu_input_t *in,
+                           long long n,
+                           ecu_run_emit_fn emit,
+                           void *ctx)
+{
+    long long stepped = 0;
+    while (stepped < n) {
+        const ecu_state_t before = *st;
+        ecu_out_run_t run;
+        run.engine_speed = STEP_ROW(cal, st, in);
+        run.engine_state = st->engine_state;
+        run.count = 1;
+        stepped++;
+
+        if (stepped < n && state_settled(cal, &before, st)) {
+            long long rest = n - stepped;
+            run.count += rest;
+            if (st->overlap_run_count != before.overlap_run_count) {
+                long long c = (long long)st->overlap_run_count + rest;
+                st->overlap_run_count = c > INT_MAX ? INT_MAX : (int)c;
+            }
+            emit(ctx, &run);
+            break;
+        }
+        emit(ctx, &run);
+    }
+    return stepped;
+}
 
 //line added
 
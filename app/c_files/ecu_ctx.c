@@ -0,0 +1,84 @@
+// app/c_files/ecu_ctx.c
+#include <stdio.h>
+#include <stdlib.h>
+#include "ecu_ctx.h"
+
+struct ecu_ctx {
+    ecu_state_t st;             // first: keeps its cache-line alignment
+    ecu_calib_t cal;
+};
+
+// aligned_alloc: ecu_state_t is _Alignas(64), which malloc does not promise.
+static ecu_ctx *ctx_alloc(void) {
+    size_t size = (sizeof(ecu_ctx) + 63) & ~(size_t)63;
+    ecu_ctx *ctx = aligned_alloc(64, size);
+    if (ctx) ecu_state_init(&ctx->st);
+    return ctx;
+}
+
+ecu_ctx *ecu_ctx_open(const char *calib_path, FILE *report) {
+    ecu_ctx *ctx = ctx_alloc();
+    if (!ctx) return NULL;
+    if (ecu_calib_load(calib_path, &ctx->cal, report) < 0) {
+        if (report) fprintf(report, "calib: cannot open %s\n", calib_path);
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+ecu_ctx *ecu_ctx_open_text(const char *calib_text, FILE *report) {
+    ecu_ctx *ctx = ctx_alloc();
+    if (!ctx) return NULL;
+    if (ecu_calib_parse(calib_text, NULL, &ctx->cal, report) < 0) { free(ctx); return NULL; }
+    return ctx;
+}
+
+ecu_ctx *ecu_ctx_create(const ecu_calib_t *cal) {
+    ecu_ctx *ctx = ctx_alloc();
+    if (!ctx) return NULL;
+    ctx->cal = *cal;
+    return ctx;
+}
+
+void ecu_ctx_free(ecu_ctx *ctx) {
+    free(ctx);
+}
+
+void ecu_ctx_reset(ecu_ctx *ctx) {
+    ecu_state_init(&ctx->st);
+}
+
+const ecu_calib_t *ecu_ctx_calib(const ecu_ctx *ctx) {
+    return &ctx->cal;
+}
+
+ecu_state_t ecu_ctx_state(const ecu_ctx *ctx) {
+    return ctx->st;
+}
+
+void ecu_ctx_set_state(ecu_ctx *ctx, const ecu_state_t *st) {
+    ctx->st = *st;
+}
+
+ecu_output_t ecu_ctx_step(ecu_ctx *ctx, const ecu_input_t *in) {
+    ecu_output_t out;
+    out.engine_speed = ecu_step(&ctx->cal, &ctx->st, in);
+    out.engine_state = ctx->st.engine_state;
+    return out;
+}
+
+void ecu_ctx_step_batch(ecu_ctx *ctx, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    ecu_state_t s = ctx->st;
+    for (size_t i = 0; i < n; i++) {
+        out[i].engine_speed = ecu_step(&ctx->cal, &s, &in[i]);
+        out[i].engine_state = s.engine_state;
+    }
+    ctx->st = s;
+}
+
+void ecu_ctx_run_columns(ecu_ctx *ctx, const ecu_columns_t *in, size_t n,
+                         int *engine_state, int *engine_speed)
+{
+    ecu_run_batch(&ctx->cal, &ctx->st, in, n, engine_state, engine_speed);
+}
@@ -0,0 +1,259 @@
+// app/c_files/ecub.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "ecub.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+_Static_assert(sizeof(ecub_header_t) == 64, "ecub header is one 64-byte unit");
+_Static_assert(sizeof(ecub_col_desc_t) == 40, "ecub column descriptor layout");
+_Static_assert(sizeof(ecub_block_header_t) == 16, "ecub block header layout");
+
+const ecub_col_desc_t ECUB_INPUT_SCHEMA[7] = {
+    { "time",                 ECUB_I64, 0 },
+    { "ignition_switch",      ECUB_I32, 0 },
+    { "acc_pedal_position",   ECUB_I32, 0 },
+    { "brake_pedal_position", ECUB_I32, 0 },
+    { "current_gear",         ECUB_I32, 0 },
+    { "cruise_enable",        ECUB_I32, 0 },
+    { "cruise_target_speed",  ECUB_I32, 0 },
+};
+
+const ecub_col_desc_t ECUB_OUTPUT_SCHEMA[3] = {
+    { "time",         ECUB_I64, 0 },
+    { "engine_state", ECUB_I32, 0 },
+    { "engine_speed", ECUB_I32, 0 },
+};
+
+static size_t align_up(size_t n) {
+    return (n + ECUB_ALIGN - 1) & ~(size_t)(ECUB_ALIGN - 1);
+}
+
+static size_t type_width(uint32_t type) {
+    return type == ECUB_I64 ? 8 : (type == ECUB_I32 ? 4 : 0);
+}
+
+static size_t schema_bytes(int ncols) {
+    return align_up(sizeof(ecub_header_t) + (size_t)ncols * sizeof(ecub_col_desc_t));
+}
+
+static size_t block_prefix_bytes(int ncols) {
+    return align_up(sizeof(ecub_block_header_t) + (size_t)ncols * sizeof(ecub_range_t));
+}
+
+int ecub_is(const void *base, size_t len) {
+    return len >= sizeof(ecub_header_t) && memcmp(base, ECUB_MAGIC, 4) == 0;
+}
+
+// ======================== Reader ========================
+struct ecub_reader {
+    const unsigned char *base;
+    size_t len;
+    size_t pos;                 // offset of the next block
+    const char *name;
+    int ncols;
+    const ecub_col_desc_t *desc;
+    const ecub_range_t *range;  // current block
+};
+
+int ecub_open_mem(const void *base, size_t len, const char *name, ecub_reader_t **out) {
+    *out = NULL;
+    if (!ecub_is(base, len)) {
+        fprintf(stderr, "%s: not an ecub file\n", name);
+        return -1;
+    }
+    ecub_header_t h;
+    memcpy(&h, base, sizeof(h));
+    if (h.endian != ECUB_ENDIAN_TAG || h.version != ECUB_VERSION) {
+        fprintf(stderr, "%s: unsupported ecub version %u or byte order\n", name, (unsigned)h.version);
+        return -1;
+    }
+    if (h.ncols == 0 || schema_bytes(h.ncols) > len) {
+        fprintf(stderr, "%s: truncated ecub schema\n", name);
+        return -1;
+    }
+    const ecub_col_desc_t *desc = (const ecub_col_desc_t *)((const unsigned char *)base + sizeof(h));
+    for (int i = 0; i < h.ncols; i++) {
+        if (!type_width(desc[i].type) || memchr(desc[i].name, '\0', ECUB_NAME_LEN) == NULL) {
+            fprintf(stderr, "%s: bad ecub column %d\n", name, i);
+            return -1;
+        }
+    }
+
+    ecub_reader_t *r = calloc(1, sizeof(*r));
+    if (!r) return -1;
+    r->base  = base;
+    r->len   = len;
+    r->pos   = schema_bytes(h.ncols);
+    r->name  = name;
+    r->ncols = h.ncols;
+    r->desc  = desc;
+    *out = r;
+    return 0;
+}
+
+int ecub_ncols(const ecub_reader_t *r) {
+    return r->ncols;
+}
+
+const ecub_col_desc_t *ecub_desc(const ecub_reader_t *r, int col) {
+    return &r->desc[col];
+}
+
+int ecub_col(const ecub_reader_t *r, const char *name) {
+    for (int i = 0; i < r->ncols; i++) {
+        if (strcmp(r->desc[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+long ecub_next(ecub_reader_t *r, const void *cols[]) {
+    if (r->pos >= r->len) return 0;
+    size_t prefix = block_prefix_bytes(r->ncols);
+    if (r->len - r->pos < prefix) goto corrupt;
+
+    ecub_block_header_t bh;
+    memcpy(&bh, r->base + r->pos, sizeof(bh));
+    if (bh.bytes > r->len - r->pos || bh.bytes < prefix) goto corrupt;
+
+    size_t off = r->pos + prefix;
+    for (int i = 0; i < r->ncols; i++) {
+        size_t n = align_up((size_t)bh.rows * type_width(r->desc[i].type));
+        if (off + n > r->pos + bh.bytes) goto corrupt;
+        cols[i] = r->base + off;
+        off += n;
+    }
+    r->range = (const ecub_range_t *)(r->base + r->pos + sizeof(bh));
+    r->pos += bh.bytes;
+    return (long)bh.rows;
+
+corrupt:
+    fprintf(stderr, "%s: corrupt ecub block at byte %zu\n", r->name, r->pos);
+    r->pos = r->len;
+    return -1;
+}
+
+ecub_range_t ecub_range(const ecub_reader_t *r, int col) {
+    return r->range[col];
+}
+
+void ecub_close(ecub_reader_t *r) {
+    free(r);
+}
+
+// ======================== Writer ========================
+struct ecub_writer {
+    int fd;
+    int failed;
+    int ncols;
+    ecub_header_t head;
+    ecub_col_desc_t *desc;
+    unsigned char *buf;         // one encoded block
+    size_t cap;
+};
+
+static void put_all(ecub_writer_t *w, const void *p, size_t n) {
+    const char *c = p;
+    while (n > 0 && !w->failed) {
+        ssize_t got = write(w->fd, c, n);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            w->failed = 1;
+            return;
+        }
+        c += got;
+        n -= (size_t)got;
+    }
+}
+
+ecub_writer_t *ecub_create(const char *path, const ecub_col_desc_t *schema, int ncols) {
+    ecub_writer_t *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->ncols = ncols;
+    w->desc  = malloc((size_t)ncols * sizeof(*w->desc));
+    w->cap   = block_prefix_bytes(ncols);
+    for (int i = 0; i < ncols; i++) w->cap += align_up(ECUB_BLOCK_ROWS * type_width(schema[i].type));
+    w->buf   = calloc(1, w->cap);
+    w->fd    = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!w->desc || !w->buf || w->fd < 0) {
+        int e = errno;
+        if (w->fd >= 0) close(w->fd);
+        free(w->desc); free(w->buf); free(w);
+        errno = e;
+        return NULL;
+    }
+    memcpy(w->desc, schema, (size_t)ncols * sizeof(*w->desc));
+
+    memcpy(w->head.magic, ECUB_MAGIC, 4);
+    w->head.endian  = ECUB_ENDIAN_TAG;
+    w->head.version = ECUB_VERSION;
+    w->head.ncols   = (uint16_t)ncols;
+
+    // Header is rewritten with the final counts in ecub_finish().
+    unsigned char *pre = calloc(1, schema_bytes(ncols));
+    if (!pre) { w->failed = 1; return w; }
+    memcpy(pre, &w->head, sizeof(w->head));
+    memcpy(pre + sizeof(w->head), w->desc, (size_t)ncols * sizeof(*w->desc));
+    put_all(w, pre, schema_bytes(ncols));
+    free(pre);
+    return w;
+}
+
+int ecub_write_block(ecub_writer_t *w, size_t n, const void *const cols[]) {
+    if (n == 0) return 0;
+    if (n > ECUB_BLOCK_ROWS) return -1;
+
+    size_t prefix = block_prefix_bytes(w->ncols);
+    memset(w->buf, 0, prefix);
+    ecub_range_t *range = (ecub_range_t *)(w->buf + sizeof(ecub_block_header_t));
+    size_t off = prefix;
+    for (int i = 0; i < w->ncols; i++) {
+        size_t width = type_width(w->desc[i].type);
+        size_t bytes = align_up(n * width);
+        memset(w->buf + off + n * width, 0, bytes - n * width);
+        memcpy(w->buf + off, cols[i], n * width);
+
+        int64_t lo, hi;
+        if (width == 8) {
+            const int64_t *v = cols[i];
+            lo = hi = v[0];
+            for (size_t k = 1; k < n; k++) { if (v[k] < lo) lo = v[k]; if (v[k] > hi) hi = v[k]; }
+        } else {
+            const int32_t *v = cols[i];
+            lo = hi = v[0];
+            for (size_t k = 1; k < n; k++) { if (v[k] < lo) lo = v[k]; if (v[k] > hi) hi = v[k]; }
+        }
+        range[i].min = lo;
+        range[i].max = hi;
+        off += bytes;
+    }
+    ecub_block_header_t bh = { (uint32_t)n, 0, off };
+    memcpy(w->buf, &bh, sizeof(bh));
+    put_all(w, w->buf, off);
+
+    w->head.rows += n;
+    w->head.nblocks++;
+    if (n > w->head.block_rows) w->head.block_rows = (uint32_t)n;
+    return w->failed ? -1 : 0;
+}
+
+int ecub_finish(ecub_writer_t *w) {
+    if (!w) return 0;
+    if (!w->failed && lseek(w->fd, 0, SEEK_SET) == 0) {
+        put_all(w, &w->head, sizeof(w->head));
+    } else {
+        w->failed = 1;
+    }
+    if (close(w->fd) != 0) w->failed = 1;
+    int rc = w->failed ? -1 : 0;
+    free(w->desc);
+    free(w->buf);
+    free(w);
+    return rc;
+}
@@ -0,0 +1,175 @@
+// app/c_files/fleet.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "fleet.h"
+#include "pool.h"
+#include "sim.h"
+#include "trace_io.h"
+
+typedef struct {
+    const ecu_calib_t *cal;
+    char  *in_path;
+    char  *out_path;
+    long   size;            // bytes, for largest-first scheduling
+    long   rows;
+    double seconds;
+    int    worker;
+    int    rc;
+} fleet_job_t;
+
+typedef struct {
+    fleet_job_t *jobs;
+    size_t       count;
+    size_t       cap;
+} job_list_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// <stem>.csv[.gz|.zst] -> <stem>_out.csv (anything else gets _out.csv appended)
+static char *output_path_for(const char *in_path) {
+    long csv = trace_csv_stem(in_path);
+    size_t stem = csv >= 0 ? (size_t)csv : strlen(in_path);
+    char *out = malloc(stem + sizeof("_out.csv"));
+    if (!out) return NULL;
+    memcpy(out, in_path, stem);
+    strcpy(out + stem, "_out.csv");
+    return out;
+}
+
+static int add_job(job_list_t *list, const ecu_calib_t *cal, const char *in_path) {
+    if (list->count == list->cap) {
+        size_t ncap = list->cap ? list->cap * 2 : 64;
+        fleet_job_t *nj = realloc(list->jobs, ncap * sizeof(*nj));
+        if (!nj) return -1;
+        list->jobs = nj; list->cap = ncap;
+    }
+    fleet_job_t *j = &list->jobs[list->count];
+    memset(j, 0, sizeof(*j));
+    j->cal = cal;
+    j->in_path = strdup(in_path);
+    j->out_path = output_path_for(in_path);
+    if (!j->in_path || !j->out_path) { free(j->in_path); free(j->out_path); return -1; }
+
+    struct stat sb;
+    j->size = (stat(in_path, &sb) == 0) ? (long)sb.st_size : 0;
+    list->count++;
+    return 0;
+}
+
+static int collect_dir(job_list_t *list, const ecu_calib_t *cal, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (trace_csv_stem(e->d_name) < 0 || strstr(e->d_name, "_out.csv")) continue;
+        size_t n = strlen(dir) + strlen(e->d_name) + 2;
+        char *path = malloc(n);
+        if (!path) break;
+        snprintf(path, n, "%s/%s", dir, e->d_name);
+        struct stat sb;
+        if (stat(path, &sb) == 0 && S_ISREG(sb.st_mode)) add_job(list, cal, path);
+        free(path);
+    }
+    closedir(d);
+    return 0;
+}
+
+static int collect_manifest(job_list_t *list, const ecu_calib_t *cal, const char *manifest) {
+    FILE *f = fopen(manifest, "r");
+    if (!f) return -1;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = trace_manifest_entry(line);
+        if (!p) continue;
+        add_job(list, cal, p);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int by_size_desc(const void *a, const void *b) {
+    const fleet_job_t *x = a, *y = b;
+    if (x->size != y->size) return x->size < y->size ? 1 : -1;
+    return strcmp(x->in_path, y->in_path);
+}
+
+static void run_job(void *arg, int worker) {
+    fleet_job_t *j = arg;
+    sim_stats_t stats;
+    double t0 = now_seconds();
+    j->rc = sim_run_csv(j->cal, j->in_path, j->out_path, WRITER_FLUSH_BATCH, &stats);
+    j->seconds = now_seconds() - t0;
+    j->rows = stats.rows;
+    j->worker = worker;
+}
+
+int fleet_run(const ecu_calib_t *cal, const char *source, int nthreads, FILE *report) {
+    job_list_t list = { NULL, 0, 0 };
+
+    struct stat sb;
+    if (stat(source, &sb) != 0) {
+        fprintf(stderr, "fleet: %s: %s\n", source, strerror(errno));
+        return 2;
+    }
+    int rc = S_ISDIR(sb.st_mode) ? collect_dir(&list, cal, source)
+                                 : collect_manifest(&list, cal, source);
+    if (rc != 0) {
+        fprintf(stderr, "fleet: cannot read %s\n", source);
+        free(list.jobs);
+        return 2;
+    }
+    if (list.count == 0) {
+        fprintf(stderr, "fleet: no input traces in %s\n", source);
+        free(list.jobs);
+        return 2;
+    }
+
+    // Largest first: big logs start early, small ones fill in behind them.
+    qsort(list.jobs, list.count, sizeof(list.jobs[0]), by_size_desc);
+
+    pool_t *pool = pool_create(nthreads);
+    if (!pool) {
+        fprintf(stderr, "fleet: cannot start worker threads\n");
+        free(list.jobs);
+        return 2;
+    }
+
+    double t0 = now_seconds();
+    for (size_t i = 0; i < list.count; i++) pool_submit(pool, run_job, &list.jobs[i]);
+    pool_wait(pool);
+    double wall = now_seconds() - t0;
+
+    long total_rows = 0;
+    int first_rc = 0, failed = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        fleet_job_t *j = &list.jobs[i];
+        if (report) {
+            fprintf(report, "fleet: %s rows=%ld ms=%.3f worker=%d%s\n",
+                    j->in_path, j->rows, j->seconds * 1e3, j->worker, j->rc ? " FAILED" : "");
+        }
+        total_rows += j->rows;
+        if (j->rc) { failed++; if (!first_rc) first_rc = j->rc; }
+    }
+    if (report) {
+        fprintf(report, "fleet: files=%zu failed=%d rows=%ld threads=%d steals=%ld wall_s=%.3f rows_per_s=%.0f\n",
+                list.count, failed, total_rows, pool_size(pool), pool_steals(pool),
+                wall, wall > 0.0 ? (double)total_rows / wall : 0.0);
+    }
+
+    pool_destroy(pool);
+    for (size_t i = 0; i < list.count; i++) {
+        free(list.jobs[i].in_path);
+        free(list.jobs[i].out_path);
+    }
+    free(list.jobs);
+    return first_rc;
+}
@@ -0,0 +1,239 @@
+// app/c_files/pipeline.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "pipeline.h"
+#include "sim.h"
+#include "trace_io.h"
+
+#define PIPE_BLOCKS  16         // blocks in flight
+#define PIPE_RING    32         // ring slots (power of two, > PIPE_BLOCKS: every block plus the end marker fits)
+#define PIPE_SPIN    256        // pause spins before a waiting stage yields the core
+#define PIPE_YIELDS  64         // yields after that, before it parks on the ring
+
+_Static_assert((PIPE_RING & (PIPE_RING - 1)) == 0, "PIPE_RING must be a power of two");
+_Static_assert(PIPE_RING > PIPE_BLOCKS, "a ring must hold every block and the end marker");
+
+// ======================== SPSC ring ========================
+// Producer and consumer indices sit on their own cache lines, each with
+// a cached copy of the other side's index, so neither side touches the
+// other's line until its cached view runs out. Indices only grow; a NULL
+// entry marks the end of the stream. A consumer that outwaits its spin and
+// yield budget parks on wake; the producer signals only when parked is set.
+typedef struct {
+    _Alignas(64) size_t tail;           // producer: next slot to fill
+    size_t head_seen;                   // producer's last view of head
+    _Alignas(64) size_t head;           // consumer: next slot to take
+    size_t tail_seen;                   // consumer's last view of tail
+    _Alignas(64) int parked;            // consumer is (about to be) in pthread_cond_wait()
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    _Alignas(64) trace_block_t *slot[PIPE_RING];
+} ring_t;
+
+// How often one stage found nothing to do, and for how long.
+typedef struct {
+    _Alignas(64) long waits;
+    double wait_s;
+} stall_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static void ring_init(ring_t *q) {
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->wake, NULL);
+}
+
+static void ring_destroy(ring_t *q) {
+    pthread_cond_destroy(&q->wake);
+    pthread_mutex_destroy(&q->lock);
+}
+
+// Sleeps until the producer moves tail past h. parked is set before tail
+// is re-read and the producer reads parked after publishing tail (both
+// seq_cst), so one of the two always sees the other: no lost wakeup.
+static void ring_park(ring_t *q, size_t h) {
+    pthread_mutex_lock(&q->lock);
+    __atomic_store_n(&q->parked, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&q->tail, __ATOMIC_SEQ_CST) == h) pthread_cond_wait(&q->wake, &q->lock);
+    __atomic_store_n(&q->parked, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Spins briefly, then yields (the other stages may share this core), then
+// parks: a stage stuck behind a blocked parser stops burning CPU.
+static void backoff(ring_t *q, size_t h, unsigned *spins, stall_t *s, double *t0) {
+    if (*spins == 0) { s->waits++; *t0 = now_seconds(); }
+    ++*spins;
+    if (*spins < PIPE_SPIN) cpu_relax();
+    else if (*spins < PIPE_SPIN + PIPE_YIELDS) sched_yield();
+    else ring_park(q, h);
+}
+
+static void ring_push(ring_t *q, trace_block_t *b) {
+    const size_t t = q->tail;
+    if (t - q->head_seen == PIPE_RING) {
+        // Cannot happen with PIPE_RING > PIPE_BLOCKS; kept for safety.
+        while (t - (q->head_seen = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) == PIPE_RING) sched_yield();
+    }
+    q->slot[t & (PIPE_RING - 1)] = b;
+    __atomic_store_n(&q->tail, t + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->parked, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&q->lock);
+        pthread_cond_signal(&q->wake);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+static trace_block_t *ring_pop(ring_t *q, stall_t *s) {
+    const size_t h = q->head;
+    if (h == q->tail_seen) {
+        unsigned spins = 0;
+        double t0 = 0.0;
+        while (h == (q->tail_seen = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))) backoff(q, h, &spins, s, &t0);
+        if (spins) s->wait_s += now_seconds() - t0;
+    }
+    trace_block_t *b = q->slot[h & (PIPE_RING - 1)];
+    __atomic_store_n(&q->head, h + 1, __ATOMIC_RELEASE);
+    return b;
+}
+
+// ======================== Stages ========================
+typedef struct {
+    trace_reader_t *r;
+    trace_sink_t   *sink;
+    ring_t free_q;              // write -> parse: blocks done with
+    ring_t parsed_q;            // parse -> compute
+    ring_t done_q;              // compute -> write
+    stall_t parse_stall, compute_stall, write_stall;
+    long blocks;
+} pipe_t;
+
+static void pipe_free(pipe_t *p) {
+    ring_destroy(&p->free_q);
+    ring_destroy(&p->parsed_q);
+    ring_destroy(&p->done_q);
+    free(p);
+}
+
+static void *parse_main(void *arg) {
+    pipe_t *p = arg;
+    for (;;) {
+        trace_block_t *b = ring_pop(&p->free_q, &p->parse_stall);
+        if (trace_read_block(p->r, b) == 0) break;
+        p->blocks++;
+        ring_push(&p->parsed_q, b);
+    }
+    ring_push(&p->parsed_q, NULL);
+    return NULL;
+}
+
+static void *write_main(void *arg) {
+    pipe_t *p = arg;
+    trace_block_t *b;
+    while ((b = ring_pop(&p->done_q, &p->write_stall)) != NULL) {
+        trace_sink_write(p->sink, b->n, b->t, b->engine_state, b->engine_speed);
+        ring_push(&p->free_q, b);
+    }
+    return NULL;
+}
+
+// ======================== Driver ========================
+int pipeline_run(const ecu_calib_t *cal,
+                 const char *in_path,
+                 const char *out_path,
+                 writer_flush_t flush,
+                 FILE *report)
+{
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+    if (trace_has_repeat(r)) {
+        // Runs are fast-forwarded, not stepped row by row.
+        trace_close(r);
+        if (report) fprintf(report, "pipeline: 'repeat' input, running serially\n");
+        return sim_run_csv(cal, in_path, out_path, flush, NULL);
+    }
+
+    pipe_t *p = aligned_alloc(64, sizeof(*p));
+    trace_block_t *blocks = malloc(PIPE_BLOCKS * sizeof(*blocks));
+    if (!p || !blocks) { free(p); free(blocks); trace_close(r); return 2; }
+    memset(p, 0, sizeof(*p));
+    ring_init(&p->free_q);
+    ring_init(&p->parsed_q);
+    ring_init(&p->done_q);
+    p->r = r;
+    p->sink = trace_sink_open(out_path, flush);
+    if (!p->sink) {
+        fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno));
+        pipe_free(p); free(blocks); trace_close(r);
+        return 4;
+    }
+    for (int i = 0; i < PIPE_BLOCKS; i++) ring_push(&p->free_q, &blocks[i]);
+
+    double t0 = now_seconds();
+    pthread_t parser, writer;
+    if (pthread_create(&parser, NULL, parse_main, p) != 0) {
+        fprintf(stderr, "pipeline: cannot start threads\n");
+        trace_sink_close(p->sink); pipe_free(p); free(blocks); trace_close(r);
+        return 2;
+    }
+    // Without a writer thread the compute stage writes its own blocks.
+    const int write_inline = pthread_create(&writer, NULL, write_main, p) != 0;
+
+    ecu_state_t st;
+    ecu_state_init(&st);
+    trace_block_t *b;
+    while ((b = ring_pop(&p->parsed_q, &p->compute_stall)) != NULL) {
+        const ecu_columns_t cols = trace_block_columns(b);
+        ecu_run_batch(cal, &st, &cols, b->n, b->engine_state, b->engine_speed);
+        if (write_inline) {
+            trace_sink_write(p->sink, b->n, b->t, b->engine_state, b->engine_speed);
+            ring_push(&p->free_q, b);
+        } else {
+            ring_push(&p->done_q, b);
+        }
+    }
+    pthread_join(parser, NULL);
+    if (!write_inline) {
+        ring_push(&p->done_q, NULL);
+        pthread_join(writer, NULL);
+    }
+    double wall = now_seconds() - t0;
+
+    long rows = trace_rows(r);
+    rc = trace_failed(r) ? 3 : 0;
+    trace_close(r);
+    if (trace_sink_close(p->sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        rc = 4;
+    }
+    if (report) {
+        fprintf(report,
+                "pipeline: rows=%ld blocks=%ld wall_s=%.3f stalls: parse=%ld (%.1f ms, no free block)"
+                " compute=%ld (%.1f ms, no parsed block) write=%ld (%.1f ms, no result block)\n",
+                rows, p->blocks, wall,
+                p->parse_stall.waits, p->parse_stall.wait_s * 1e3,
+                p->compute_stall.waits, p->compute_stall.wait_s * 1e3,
+                p->write_stall.waits, p->write_stall.wait_s * 1e3);
+    }
+    pipe_free(p);
+    free(blocks);
+    return rc;
+}
@@ -0,0 +1,209 @@
+// app/c_files/pool.c
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include "pool.h"
+
+typedef struct {
+    pool_fn fn;
+    void   *arg;
+} task_t;
+
+typedef struct {
+    pthread_mutex_t mu;
+    task_t *tasks;          // ring buffer, oldest at head
+    size_t  head;           // next task taken, by owner or thief
+    size_t  count;
+    size_t  cap;
+    pthread_t thread;
+    pool_t *pool;
+    int     id;
+} worker_t;
+
+struct pool {
+    worker_t *workers;
+    int       nworkers;
+    unsigned  next;         // round-robin submit cursor
+
+    pthread_mutex_t mu;     // guards the counters below
+    pthread_cond_t  work_cv;
+    pthread_cond_t  done_cv;
+    size_t queued;          // submitted, not yet taken
+    size_t pending;         // submitted, not yet finished
+    long   steals;
+    int    stop;
+};
+
+int pool_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static int deque_push(worker_t *w, task_t t) {
+    pthread_mutex_lock(&w->mu);
+    if (w->count == w->cap) {
+        size_t ncap = w->cap ? w->cap * 2 : 64;
+        task_t *nt = malloc(ncap * sizeof(*nt));
+        if (!nt) { pthread_mutex_unlock(&w->mu); return -1; }
+        for (size_t i = 0; i < w->count; i++) nt[i] = w->tasks[(w->head + i) % w->cap];
+        free(w->tasks);
+        w->tasks = nt; w->head = 0; w->cap = ncap;
+    }
+    w->tasks[(w->head + w->count) % w->cap] = t;
+    w->count++;
+    pthread_mutex_unlock(&w->mu);
+    return 0;
+}
+
+// Owner and thieves both take the oldest task (head), so each worker runs
+// its tasks in submission order and a thief takes the one queued longest.
+// The lock is held for a few loads, so a thief waits on it rather than
+// skipping a victim it could have taken from.
+static int deque_take(worker_t *w, task_t *out) {
+    int ok = 0;
+    pthread_mutex_lock(&w->mu);
+    if (w->count) {
+        *out = w->tasks[w->head];
+        w->head = (w->head + 1) % w->cap;
+        w->count--;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&w->mu);
+    return ok;
+}
+
+static int take_task(worker_t *self, task_t *out) {
+    pool_t *p = self->pool;
+    if (deque_take(self, out)) return 1;
+    for (int k = 1; k < p->nworkers; k++) {
+        worker_t *victim = &p->workers[(self->id + k) % p->nworkers];
+        if (deque_take(victim, out)) {
+            pthread_mutex_lock(&p->mu);
+            p->steals++;
+            pthread_mutex_unlock(&p->mu);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *self = arg;
+    pool_t *p = self->pool;
+
+    for (;;) {
+        task_t t;
+        if (take_task(self, &t)) {
+            pthread_mutex_lock(&p->mu);
+            p->queued--;
+            pthread_mutex_unlock(&p->mu);
+
+            t.fn(t.arg, self->id);
+
+            pthread_mutex_lock(&p->mu);
+            if (--p->pending == 0) pthread_cond_broadcast(&p->done_cv);
+            pthread_mutex_unlock(&p->mu);
+            continue;
+        }
+
+        // queued > 0 with every deque empty only while a task is between
+        // the counter and a deque (submit) or taken and not yet counted
+        // off: give that thread the core instead of spinning on p->mu.
+        pthread_mutex_lock(&p->mu);
+        int waited = 0;
+        while (p->queued == 0 && !p->stop) { pthread_cond_wait(&p->work_cv, &p->mu); waited = 1; }
+        int quit = p->stop && p->queued == 0;
+        pthread_mutex_unlock(&p->mu);
+        if (quit) break;
+        if (!waited) sched_yield();
+    }
+    return NULL;
+}
+
+pool_t *pool_create(int nthreads) {
+    if (nthreads <= 0) nthreads = pool_default_threads();
+
+    pool_t *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+    p->workers = calloc((size_t)nthreads, sizeof(worker_t));
+    if (!p->workers) { free(p); return NULL; }
+    pthread_mutex_init(&p->mu, NULL);
+    pthread_cond_init(&p->work_cv, NULL);
+    pthread_cond_init(&p->done_cv, NULL);
+
+    for (int i = 0; i < nthreads; i++) {
+        worker_t *w = &p->workers[i];
+        pthread_mutex_init(&w->mu, NULL);
+        w->pool = p;
+        w->id = i;
+    }
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&p->workers[i].thread, NULL, worker_main, &p->workers[i]) != 0) break;
+        p->nworkers++;
+    }
+    if (p->nworkers == 0) {
+        pthread_mutex_destroy(&p->mu);
+        free(p->workers);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+int pool_submit(pool_t *p, pool_fn fn, void *arg) {
+    // Count first so a worker never sees a task it was not told about.
+    pthread_mutex_lock(&p->mu);
+    p->queued++;
+    p->pending++;
+    unsigned slot = p->next++ % (unsigned)p->nworkers;
+    pthread_mutex_unlock(&p->mu);
+
+    task_t t = { fn, arg };
+    int rc = deque_push(&p->workers[slot], t);
+
+    pthread_mutex_lock(&p->mu);
+    if (rc != 0) {
+        p->queued--;
+        if (--p->pending == 0) pthread_cond_broadcast(&p->done_cv);
+    } else {
+        pthread_cond_broadcast(&p->work_cv);
+    }
+    pthread_mutex_unlock(&p->mu);
+    return rc;
+}
+
+void pool_wait(pool_t *p) {
+    pthread_mutex_lock(&p->mu);
+    while (p->pending) pthread_cond_wait(&p->done_cv, &p->mu);
+    pthread_mutex_unlock(&p->mu);
+}
+
+void pool_destroy(pool_t *p) {
+    if (!p) return;
+    pool_wait(p);
+
+    pthread_mutex_lock(&p->mu);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->work_cv);
+    pthread_mutex_unlock(&p->mu);
+
+    for (int i = 0; i < p->nworkers; i++) pthread_join(p->workers[i].thread, NULL);
+    for (int i = 0; i < p->nworkers; i++) {
+        pthread_mutex_destroy(&p->workers[i].mu);
+        free(p->workers[i].tasks);
+    }
+    pthread_cond_destroy(&p->work_cv);
+    pthread_cond_destroy(&p->done_cv);
+    pthread_mutex_destroy(&p->mu);
+    free(p->workers);
+    free(p);
+}
+
+int pool_size(const pool_t *p) {
+    return p->nworkers;
+}
+
+long pool_steals(const pool_t *p) {
+    return p->steals;
+}
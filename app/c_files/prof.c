@@ -0,0 +1,130 @@
+// app/c_files/prof.c
+#include "prof.h"
+
+#ifdef ECU_PROFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROF_BUCKETS 40     // log2(ticks per row), last one open-ended
+
+typedef struct {
+    uint64_t rows;          // rows measured
+    uint64_t ticks;
+    uint64_t bucket[PROF_BUCKETS];
+} prof_hist_t;
+
+static const char *const STAGE_NAME[PROF_STAGES] = {
+    "parse", "ignition", "limp", "bto", "speed", "limp_cap", "rev", "slew", "write"
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+static const char *const TICK_UNIT = "tsc";
+#else
+static const char *const TICK_UNIT = "ns";
+#endif
+
+static prof_hist_t hist[PROF_STAGES];
+static uint64_t timer_overhead;
+static _Thread_local unsigned sample_counter;
+
+static int log2_bucket(uint64_t v) {
+    int b = 0;
+    while (v > 1 && b < PROF_BUCKETS - 1) { v >>= 1; b++; }
+    return b;
+}
+
+int prof_sample(void) {
+    return (sample_counter++ % PROF_SAMPLE_EVERY) == 0;
+}
+
+// Relaxed atomics: sampled rows are rare enough that contention between
+// fleet/segment workers does not matter.
+void prof_add(prof_stage_t stage, uint64_t ticks, uint64_t rows) {
+    if (rows == 0) return;
+    prof_hist_t *h = &hist[stage];
+    __atomic_fetch_add(&h->rows, rows, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->ticks, ticks, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->bucket[log2_bucket(ticks / rows)], rows, __ATOMIC_RELAXED);
+}
+
+// Bucket holding quantile q, reported as its lower edge 2^b.
+static uint64_t quantile(const prof_hist_t *h, double q) {
+    uint64_t want = (uint64_t)((double)h->rows * q), seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen > want) return 1ULL << b;
+    }
+    return 1ULL << (PROF_BUCKETS - 1);
+}
+
+static double mean(const prof_hist_t *h) {
+    return h->rows ? (double)h->ticks / (double)h->rows : 0.0;
+}
+
+static void prof_dump(void) {
+    double total = 0.0;
+    for (int s = 0; s < PROF_STAGES; s++) total += mean(&hist[s]);
+
+    fprintf(stderr, "profile: ticks=%s per row, timer overhead ~%llu, 1/%d rows sampled per stage\n",
+            TICK_UNIT, (unsigned long long)timer_overhead, PROF_SAMPLE_EVERY);
+    fprintf(stderr, "%-9s %12s %10s %8s %8s %7s\n", "stage", "rows", "mean", "p50>=", "p99>=", "share");
+    for (int s = 0; s < PROF_STAGES; s++) {
+        const prof_hist_t *h = &hist[s];
+        if (!h->rows) continue;
+        fprintf(stderr, "%-9s %12llu %10.1f %8llu %8llu %6.1f%%\n", STAGE_NAME[s],
+                (unsigned long long)h->rows, mean(h),
+                (unsigned long long)quantile(h, 0.50), (unsigned long long)quantile(h, 0.99),
+                total > 0.0 ? 100.0 * mean(h) / total : 0.0);
+        fprintf(stderr, "  hist:");
+        for (int b = 0; b < PROF_BUCKETS; b++) {
+            if (h->bucket[b]) fprintf(stderr, " 2^%d:%llu", b, (unsigned long long)h->bucket[b]);
+        }
+        fputc('\n', stderr);
+    }
+
+    const char *env = getenv("ECU_PROFILE_OUT");
+    const char *path = (env && env[0]) ? env : "ecu_profile.json";
+    FILE *f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "profile: cannot write %s\n", path); return; }
+    fprintf(f, "{\n  \"unit\": \"%s\",\n  \"timer_overhead\": %llu,\n  \"sample_every\": %d,\n  \"stages\": [",
+            TICK_UNIT, (unsigned long long)timer_overhead, PROF_SAMPLE_EVERY);
+    int first = 1;
+    for (int s = 0; s < PROF_STAGES; s++) {
+        const prof_hist_t *h = &hist[s];
+        if (!h->rows) continue;
+        fprintf(f, "%s\n    { \"stage\": \"%s\", \"rows\": %llu, \"ticks\": %llu, \"mean\": %.2f, "
+                   "\"share\": %.4f, \"log2_buckets\": [",
+                first ? "" : ",", STAGE_NAME[s], (unsigned long long)h->rows,
+                (unsigned long long)h->ticks, mean(h), total > 0.0 ? mean(h) / total : 0.0);
+        for (int b = 0; b < PROF_BUCKETS; b++) {
+            fprintf(f, "%s%llu", b ? ", " : "", (unsigned long long)h->bucket[b]);
+        }
+        fprintf(f, "] }");
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    fprintf(stderr, "profile: written to %s\n", path);
+}
+
+void prof_init(void) {
+    static int done;
+    if (done) return;
+    done = 1;
+
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t a = prof_now(), b = prof_now();
+        if (b - a < best) best = b - a;
+    }
+    timer_overhead = best;
+    atexit(prof_dump);
+}
+
+#else
+
+typedef int prof_disabled_t;    // keep the translation unit non-empty
+
+#endif
@@ -0,0 +1,90 @@
+// app/c_files/rle.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+
+typedef struct {
+    trace_sink_t *sink;
+    int64_t t;              // time of the next output row
+} emit_ctx_t;
+
+static void emit_run(void *ctx, const ecu_out_run_t *run) {
+    emit_ctx_t *e = (emit_ctx_t *)ctx;
+    trace_sink_write_run(e->sink, e->t, run->engine_state, run->engine_speed, run->count);
+    e->t += run->count;
+}
+
+int rle_run_reader(const ecu_calib_t *cal, trace_reader_t *r, trace_sink_t *sink,
+                   rle_stats_t *stats)
+{
+    rle_stats_t s = { 0, 0, 0 };
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) return 4;
+
+    ecu_state_t st;
+    ecu_state_init(&st);
+    ecu_input_t cur;
+    int64_t t0 = 0;
+    long long n = 0;            // rows in the open run
+
+    while (trace_read_block(r, blk) > 0) {
+        for (size_t i = 0; i < blk->n; i++) {
+            const ecu_input_t in = {
+                blk->ign[i], blk->acc[i], blk->brk[i],
+                blk->gear[i], blk->cc_en[i], blk->cc_tgt[i]
+            };
+            if (n > 0 && blk->t[i] == t0 + n && memcmp(&in, &cur, sizeof(in)) == 0) {
+                n += blk->rep[i];
+                continue;
+            }
+            if (n > 0) {
+                emit_ctx_t e = { sink, t0 };
+                s.stepped += ecu_run_constant(cal, &st, &cur, n, emit_run, &e);
+                s.rows += n;
+                s.runs++;
+            }
+            cur = in;
+            t0 = blk->t[i];
+            n = blk->rep[i];
+        }
+    }
+    if (n > 0) {
+        emit_ctx_t e = { sink, t0 };
+        s.stepped += ecu_run_constant(cal, &st, &cur, n, emit_run, &e);
+        s.rows += n;
+        s.runs++;
+    }
+
+    free(blk);
+    if (stats) *stats = s;
+    return trace_failed(r) ? 3 : 0;
+}
+
+int rle_run(const ecu_calib_t *cal,
+            const char *in_path,
+            const char *out_path,
+            int rle_out,
+            writer_flush_t flush,
+            FILE *report)
+{
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+    trace_sink_t *sink = rle_out ? trace_sink_open_rle(out_path, flush) : trace_sink_open(out_path, flush);
+    if (!sink) { fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno)); trace_close(r); return 4; }
+
+    rle_stats_t s;
+    rc = rle_run_reader(cal, r, sink, &s);
+    trace_close(r);
+    if (trace_sink_close(sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    if (report && rc == 0) {
+        fprintf(report, "rle: %lld rows in %lld runs, %lld stepped (%.2f%%)\n",
+                s.rows, s.runs, s.stepped, s.rows ? 100.0 * (double)s.stepped / (double)s.rows : 0.0);
+    }
+    return rc;
+}
@@ -0,0 +1,184 @@
+// app/c_files/segment.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "segment.h"
+#include "trace_io.h"
+#include "pool.h"
+
+#define SEGMENTS_PER_THREAD 8
+
+// Whole trace, column by column.
+typedef struct {
+    size_t   n, cap;
+    int64_t *t;
+    int     *in[6];             // ecu_columns_t order
+    int     *engine_state;
+    int     *engine_speed;
+} table_t;
+
+typedef struct {
+    const ecu_calib_t *cal;
+    const table_t     *tab;
+    size_t start, n;
+} seg_job_t;
+
+static void table_free(table_t *tab) {
+    free(tab->t);
+    for (int c = 0; c < 6; c++) free(tab->in[c]);
+    free(tab->engine_state);
+    free(tab->engine_speed);
+}
+
+static int table_reserve(table_t *tab, size_t need) {
+    if (need <= tab->cap) return 0;
+    size_t ncap = tab->cap ? tab->cap : TRACE_BLOCK_ROWS * 16;
+    while (ncap < need) ncap *= 2;
+
+    void *p = realloc(tab->t, ncap * sizeof(*tab->t));
+    if (!p) return -1;
+    tab->t = p;
+    for (int c = 0; c < 6; c++) {
+        p = realloc(tab->in[c], ncap * sizeof(int));
+        if (!p) return -1;
+        tab->in[c] = p;
+    }
+    tab->cap = ncap;
+    return 0;
+}
+
+static int table_load(trace_reader_t *r, table_t *tab) {
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) return -1;
+    while (trace_read_block(r, blk) > 0) {
+        const int *src[6] = { blk->ign, blk->acc, blk->brk, blk->gear, blk->cc_en, blk->cc_tgt };
+        if (!trace_has_repeat(r)) {
+            if (table_reserve(tab, tab->n + blk->n) != 0) { free(blk); return -1; }
+            memcpy(tab->t + tab->n, blk->t, blk->n * sizeof(*tab->t));
+            for (int c = 0; c < 6; c++) memcpy(tab->in[c] + tab->n, src[c], blk->n * sizeof(int));
+            tab->n += blk->n;
+            continue;
+        }
+        // 'repeat' rows are expanded: segments cut at any row
+        for (size_t i = 0; i < blk->n; i++) {
+            if (table_reserve(tab, tab->n + (size_t)blk->rep[i]) != 0) { free(blk); return -1; }
+            for (int k = 0; k < blk->rep[i]; k++, tab->n++) {
+                tab->t[tab->n] = blk->t[i] + k;
+                for (int c = 0; c < 6; c++) tab->in[c][tab->n] = src[c][i];
+            }
+        }
+    }
+    free(blk);
+
+    size_t n = tab->n ? tab->n : 1;
+    tab->engine_state = malloc(n * sizeof(int));
+    tab->engine_speed = malloc(n * sizeof(int));
+    return (tab->engine_state && tab->engine_speed) ? 0 : -1;
+}
+
+static void run_segment(void *arg, int worker) {
+    (void)worker;
+    seg_job_t *j = arg;
+    const table_t *tab = j->tab;
+    const size_t s = j->start;
+    const ecu_columns_t cols = {
+        tab->in[0] + s, tab->in[1] + s, tab->in[2] + s,
+        tab->in[3] + s, tab->in[4] + s, tab->in[5] + s
+    };
+    ecu_state_t st;
+    ecu_state_init(&st);
+    ecu_run_batch(j->cal, &st, &cols, j->n, tab->engine_state + s, tab->engine_speed + s);
+}
+
+// Cuts at the first ignition-off row at or after each evenly spaced
+// target; a segment may start on the off row itself since its output does
+// not depend on the incoming state. Returns the segment count.
+static size_t plan_segments(const table_t *tab, size_t want, seg_job_t *jobs) {
+    const int *ign = tab->in[0];
+    size_t step = tab->n / want;
+    size_t count = 0, start = 0;
+    for (size_t k = 1; k < want && step > 0; k++) {
+        size_t i = k * step;
+        if (i <= start) i = start + 1;
+        while (i < tab->n && ign[i] != 0) i++;
+        if (i >= tab->n) break;
+        jobs[count].start = start;
+        jobs[count].n = i - start;
+        count++;
+        start = i;
+    }
+    jobs[count].start = start;
+    jobs[count].n = tab->n - start;
+    return count + 1;
+}
+
+int segment_run(const ecu_calib_t *cal,
+                const char *in_path,
+                const char *out_path,
+                int nthreads,
+                writer_flush_t flush,
+                FILE *report)
+{
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+
+    table_t tab;
+    memset(&tab, 0, sizeof(tab));
+    if (table_load(r, &tab) != 0) {
+        fprintf(stderr, "%s: out of memory loading trace\n", in_path);
+        trace_close(r); table_free(&tab);
+        return 3;
+    }
+    rc = trace_failed(r) ? 3 : 0;
+    trace_close(r);
+    if (rc) { table_free(&tab); return rc; }
+
+    pool_t *pool = pool_create(nthreads);
+    if (!pool) {
+        fprintf(stderr, "segments: cannot start worker threads\n");
+        table_free(&tab);
+        return 2;
+    }
+
+    // The SCR9 latch only resyncs at ignition-off when it is cleared there.
+    int serial = !cal->limp_clear_on_ignition_off || pool_size(pool) == 1;
+    size_t want = serial ? 1 : (size_t)pool_size(pool) * SEGMENTS_PER_THREAD;
+    seg_job_t *jobs = calloc(want, sizeof(*jobs));
+    if (!jobs) { pool_destroy(pool); table_free(&tab); return 2; }
+
+    size_t nseg = plan_segments(&tab, want, jobs);
+    for (size_t i = 0; i < nseg; i++) {
+        jobs[i].cal = cal;
+        jobs[i].tab = &tab;
+        pool_submit(pool, run_segment, &jobs[i]);
+    }
+    pool_wait(pool);
+
+    if (report) {
+        fprintf(report, "segments: rows=%zu segments=%zu threads=%d steals=%ld%s\n",
+                tab.n, nseg, pool_size(pool), pool_steals(pool),
+                cal->limp_clear_on_ignition_off ? "" : " serial (limp latch survives ignition-off)");
+    }
+    pool_destroy(pool);
+    free(jobs);
+
+    // --- Stitch: segments already sit at their rows, write in order ---
+    trace_sink_t *sink = trace_sink_open(out_path, flush);
+    if (!sink) {
+        fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno));
+        table_free(&tab);
+        return 4;
+    }
+    for (size_t s = 0; s < tab.n; s += TRACE_BLOCK_ROWS) {
+        size_t n = tab.n - s < TRACE_BLOCK_ROWS ? tab.n - s : TRACE_BLOCK_ROWS;
+        trace_sink_write(sink, n, tab.t + s, tab.engine_state + s, tab.engine_speed + s);
+    }
+    table_free(&tab);
+    if (trace_sink_close(sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    return 0;
+}
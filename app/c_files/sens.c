@@ -0,0 +1,105 @@
+// app/c_files/sens.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "sens.h"
+#include "trace_io.h"
+#include "writer.h"
+
+typedef struct {
+    long   rows;                // engine-on rows
+    double sum[ECU_NSENS];
+    double sum_abs[ECU_NSENS];
+    double max_abs[ECU_NSENS];
+} sens_agg_t;
+
+static void write_row(writer_t *w, int64_t t, int es, int spd, const ecu_sens_t *s) {
+    char num[32];
+    writer_i64(w, t);
+    writer_char(w, ',');
+    writer_i64(w, es);
+    writer_char(w, ',');
+    writer_i64(w, spd);
+    for (int k = 0; k < ECU_NSENS; k++) {
+        int n = snprintf(num, sizeof(num), ",%.9g", s->d_speed[k]);
+        writer_bytes(w, num, (size_t)n);
+    }
+    writer_row_end(w);
+}
+
+int sens_run(const ecu_calib_t *cal,
+             const char *in_path,
+             const char *out_path,
+             FILE *report)
+{
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+
+    writer_t *w = NULL;
+    if (out_path) {
+        w = writer_open(out_path, WRITER_FLUSH_BATCH);
+        if (!w) {
+            fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno));
+            trace_close(r);
+            return 4;
+        }
+        writer_str(w, "time,engine_state,engine_speed");
+        for (int k = 0; k < ECU_NSENS; k++) {
+            writer_str(w, ",d_");
+            writer_str(w, ECU_SENS_KEY[k]);
+        }
+        writer_row_end(w);
+    }
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    sens_agg_t *agg = calloc(1, sizeof(*agg));
+    if (!blk || !agg) { free(blk); free(agg); trace_close(r); if (w) writer_close(w); return 2; }
+
+    ecu_state_t st;
+    ecu_state_init(&st);
+    ecu_sens_t sens;
+    memset(&sens, 0, sizeof(sens));
+
+    while (trace_read_block(r, blk) > 0) {
+        for (size_t i = 0; i < blk->n; i++) {
+            const ecu_input_t in = {
+                blk->ign[i], blk->acc[i], blk->brk[i],
+                blk->gear[i], blk->cc_en[i], blk->cc_tgt[i]
+            };
+            for (int rep = 0; rep < blk->rep[i]; rep++) {
+                int spd = ecu_step_sens(cal, &st, &sens, &in);
+                if (st.engine_state) {
+                    agg->rows++;
+                    for (int k = 0; k < ECU_NSENS; k++) {
+                        double d = sens.d_speed[k], a = d < 0.0 ? -d : d;
+                        agg->sum[k] += d;
+                        agg->sum_abs[k] += a;
+                        if (a > agg->max_abs[k]) agg->max_abs[k] = a;
+                    }
+                }
+                if (w) write_row(w, blk->t[i] + rep, st.engine_state, spd, &sens);
+            }
+        }
+    }
+
+    if (trace_failed(r)) rc = 3;
+    if (report) {
+        const double n = agg->rows ? (double)agg->rows : 1.0;
+        fprintf(report, "param,mean_d_speed,mean_abs_d_speed,max_abs_d_speed,final_d_speed\n");
+        for (int k = 0; k < ECU_NSENS; k++) {
+            fprintf(report, "%s,%.6g,%.6g,%.6g,%.6g\n", ECU_SENS_KEY[k],
+                    agg->sum[k] / n, agg->sum_abs[k] / n, agg->max_abs[k], sens.d_speed[k]);
+        }
+    }
+
+    free(agg);
+    free(blk);
+    trace_close(r);
+    if (w && writer_close(w) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        rc = 4;
+    }
+    return rc;
+}
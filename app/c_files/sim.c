@@ -0,0 +1,185 @@
+// app/c_files/sim.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+#include "sim.h"
+#include "trace_io.h"
+#include "prof.h"
+#include "checkpoint.h"
+#include "rle.h"
+
+// --- Rows: parse a block, run it, write it ---
+static void run_text_rows(const ecu_calib_t *cal, trace_reader_t *r, trace_sink_t *sink,
+                          trace_block_t *blk, ecu_state_t *st)
+{
+    for (;;) {
+        PROF_BLOCK_BEGIN(prof_parse);
+        size_t n = trace_read_block(r, blk);
+        PROF_BLOCK_END(prof_parse, PROF_PARSE, n);
+        if (n == 0) break;
+
+        const ecu_columns_t cols = trace_block_columns(blk);
+        ecu_run_batch(cal, st, &cols, n, blk->engine_state, blk->engine_speed);
+        PROF_BLOCK_BEGIN(prof_write);
+        trace_sink_write(sink, n, blk->t, blk->engine_state, blk->engine_speed);
+        PROF_BLOCK_END(prof_write, PROF_WRITE, n);
+    }
+}
+
+int sim_run_csv(const ecu_calib_t *cal,
+                const char *in_path,
+                const char *out_path,
+                writer_flush_t flush,
+                sim_stats_t *stats)
+{
+    if (stats) stats->rows = 0;
+
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+    trace_sink_t *sink = trace_sink_open(out_path, flush);
+    if (!sink) { fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno)); trace_close(r); return 4; }
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) { trace_close(r); trace_sink_close(sink); return 4; }
+
+    ecu_state_t st;   // last emitted speed + SCR9/SCR10 latches
+    ecu_state_init(&st);
+
+    int rc_in = 0;
+    if (trace_has_repeat(r)) {
+        // --- Runs: 'repeat' rows are fast-forwarded, output in full ---
+        rle_stats_t rs;
+        rc_in = rle_run_reader(cal, r, sink, &rs);
+    } else if (trace_is_binary(r)) {
+        // --- Rows: columns straight from the mapping, no decoding ---
+        trace_view_t v;
+        while (trace_view_next(r, &v) > 0) {
+            ecu_run_batch(cal, &st, &v.in, v.n, blk->engine_state, blk->engine_speed);
+            PROF_BLOCK_BEGIN(prof_write);
+            trace_sink_write(sink, v.n, v.t, blk->engine_state, blk->engine_speed);
+            PROF_BLOCK_END(prof_write, PROF_WRITE, v.n);
+        }
+    } else {
+        run_text_rows(cal, r, sink, blk, &st);
+    }
+
+    if (stats) stats->rows = trace_rows(r);
+    if (trace_failed(r)) rc_in = 3;
+    free(blk);
+    trace_close(r);
+    if (trace_sink_close(sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    return rc_in;
+}
+
+// --- Checkpointed runs ---
+// Length of a regular-file output, CKPT_OUT_UNKNOWN for stdout or a pipe.
+static uint64_t output_bytes(const char *path) {
+    struct stat sb;
+    if (strcmp(path, "-") == 0 || stat(path, &sb) != 0 || !S_ISREG(sb.st_mode)) return CKPT_OUT_UNKNOWN;
+    return (uint64_t)sb.st_size;
+}
+
+static int truncate_output(const char *path, uint64_t len) {
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_BINARY);
+    if (fd < 0) return -1;
+    int rc = _chsize_s(fd, (long long)len) == 0 ? 0 : -1;
+    _close(fd);
+    return rc;
+#else
+    return truncate(path, (off_t)len);
+#endif
+}
+
+int sim_resume_csv(const ecu_calib_t *cal,
+                   const char *in_path,
+                   const char *out_path,
+                   writer_flush_t flush,
+                   const char *ckpt_path,
+                   sim_stats_t *stats)
+{
+    if (stats) stats->rows = 0;
+
+    ecu_checkpoint_t ck;
+    int have = ckpt_load(ckpt_path, &ck);
+    if (have < 0) return 7;
+
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+    if (trace_is_binary(r) || trace_has_repeat(r)) {
+        fprintf(stderr, "%s: --resume needs a CSV input without 'repeat'\n", in_path);
+        trace_close(r);
+        return 7;
+    }
+    trace_hold_partial(r);      // the logger may be mid-line
+
+    const unsigned long long calib_hash = ecu_calib_hash(cal);
+    ecu_state_t st;
+    ecu_state_init(&st);
+    trace_sink_t *sink;
+    if (have == 0) {
+        const char *why = NULL;
+        if (ck.calib_hash != calib_hash)                       why = "calibration changed";
+        else if (ck.header_hash != trace_header_hash(r))       why = "input header changed";
+        else if (trace_resume(r, ck.offset, (long)ck.rows))    why = "input is shorter than the checkpoint";
+        else if (ck.out_bytes != CKPT_OUT_UNKNOWN) {
+            // Rows written after the checkpoint was taken are replayed below.
+            uint64_t have_bytes = output_bytes(out_path);
+            if (have_bytes == CKPT_OUT_UNKNOWN || have_bytes < ck.out_bytes)
+                why = "output is shorter than the checkpoint";
+            else if (have_bytes > ck.out_bytes && truncate_output(out_path, ck.out_bytes) != 0)
+                why = "cannot truncate the output to the checkpoint";
+        }
+        if (why) {
+            fprintf(stderr, "checkpoint %s: %s; delete it to start over\n", ckpt_path, why);
+            trace_close(r);
+            return 7;
+        }
+        st = ck.state;
+        sink = trace_sink_append(out_path, flush);
+    } else {
+        sink = trace_sink_open(out_path, flush);
+    }
+    if (!sink) { fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno)); trace_close(r); return 4; }
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) { trace_close(r); trace_sink_close(sink); return 4; }
+
+    long before = trace_rows(r);
+    run_text_rows(cal, r, sink, blk, &st);
+    if (stats) stats->rows = trace_rows(r) - before;
+
+    ck.state       = st;
+    ck.rows        = trace_rows(r);
+    ck.offset      = trace_offset(r);
+    ck.calib_hash  = calib_hash;
+    ck.header_hash = trace_header_hash(r);
+    // A corrupt stream stopped early: ck would skip the unread rows.
+    const int failed = trace_failed(r);
+    free(blk);
+    trace_close(r);
+
+    // Output first, then the checkpoint: a crash in between leaves output
+    // past ck.out_bytes, which the next resume truncates before replaying
+    // those rows.
+    if (trace_sink_close(sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    if (failed) return 3;
+    ck.out_bytes = output_bytes(out_path);
+    return ckpt_save(ckpt_path, &ck) == 0 ? 0 : 7;
+}
@@ -0,0 +1,101 @@
+// app/c_files/stream.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "stream.h"
+#include "trace_io.h"
+#include "calwatch.h"
+
+// Latency histogram: 1 us buckets up to LAT_BUCKETS us, plus overflow.
+#define LAT_BUCKETS 10000
+
+typedef struct {
+    long    count[LAT_BUCKETS + 1];
+    long    rows;
+    long    over_budget;
+    int64_t max_ns;
+} latency_t;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void latency_add(latency_t *h, int64_t ns, long rows) {
+    int64_t us = ns / 1000;
+    h->count[us < LAT_BUCKETS ? us : LAT_BUCKETS] += rows;
+    h->rows += rows;
+    if (us >= STREAM_BUDGET_US) h->over_budget += rows;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+// Upper edge (us) of the bucket holding quantile q.
+static long latency_quantile(const latency_t *h, double q) {
+    long want = (long)((double)h->rows * q);
+    if (want >= h->rows) want = h->rows - 1;
+    long seen = 0;
+    for (long b = 0; b <= LAT_BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen > want) return b + 1;
+    }
+    return LAT_BUCKETS;
+}
+
+int stream_run(const ecu_calib_t *cal,
+               const char *calib_path,
+               const char *in_path,
+               const char *out_path,
+               FILE *report)
+{
+    trace_reader_t *r;
+    int rc = trace_open(in_path, &r);
+    if (rc) return rc;
+    if (trace_has_repeat(r)) {
+        fprintf(stderr, "%s: --stream does not take 'repeat' (run-length encoded) inputs\n", in_path);
+        trace_close(r);
+        return 6;
+    }
+
+    trace_sink_t *sink = trace_sink_open(out_path, WRITER_FLUSH_BATCH);
+    if (!sink) { fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno)); trace_close(r); return 4; }
+    trace_sink_flush(sink);     // header goes out before the first row
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    latency_t *lat = calloc(1, sizeof(*lat));
+    if (!blk || !lat) { free(blk); free(lat); trace_close(r); trace_sink_close(sink); return 4; }
+
+    ecu_state_t st;
+    ecu_state_init(&st);
+    calwatch_t *watch = calib_path ? calwatch_start(calib_path, cal, stderr) : NULL;
+
+    // --- Rows: whatever has arrived, straight through and out ---
+    long row = 0;
+    while (trace_read_ready(r, blk) > 0) {
+        if (watch) cal = calwatch_current(watch, row);
+        const ecu_columns_t cols = trace_block_columns(blk);
+        ecu_run_batch(cal, &st, &cols, blk->n, blk->engine_state, blk->engine_speed);
+        row += (long)blk->n;
+        trace_sink_write(sink, blk->n, blk->t, blk->engine_state, blk->engine_speed);
+        trace_sink_flush(sink);
+        latency_add(lat, now_ns() - trace_ready_ns(r), (long)blk->n);
+    }
+
+    if (report && lat->rows > 0) {
+        fprintf(report, "stream: rows=%ld p50_us<=%ld p99_us<=%ld max_us=%.1f over_%dus=%ld\n",
+                lat->rows, latency_quantile(lat, 0.50), latency_quantile(lat, 0.99),
+                (double)lat->max_ns / 1e3, STREAM_BUDGET_US, lat->over_budget);
+    }
+
+    calwatch_stop(watch);
+    free(lat);
+    free(blk);
+    trace_close(r);
+    if (trace_sink_close(sink) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    return 0;
+}
@@ -0,0 +1,472 @@
+// app/c_files/sweep.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "sweep.h"
+#include "trace_io.h"
+
+#define SWEEP_MAX_VARIANTS 65536
+#define SWEEP_MAX_AXES     8
+
+// The lane kernel is built for AVX2 and baseline SSE2 and picked at load
+// time; the Makefile's -O2 only vectorises trivially cheap loops, so the
+// kernel asks for the full cost model itself.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define SWEEP_KERNEL __attribute__((target_clones("avx2", "default"), optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#elif defined(__GNUC__) && !defined(__clang__)
+#define SWEEP_KERNEL __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#else
+#define SWEEP_KERNEL
+#endif
+
+typedef struct {
+    ecu_calib_t cal;
+    char name[128];
+} variant_t;
+
+// One lane per variant. Calibration columns are the prepared (cal->run)
+// values so the kernel does no sanitising.
+typedef struct {
+    int n;
+
+    int    *max, *brake_gain, *cc_gear_min, *cc_tmin, *cc_thi, *cc_step;
+    int    *drag, *idle_gear_max, *idle_target, *idle_step;
+    int    *slew_rise, *slew_fall, *acc_ovl, *brk_ovl, *limp_need, *limp_cap, *limp_clear;
+    int    *rev_soft, *rev_hard, *rev_hyst, *rev_step, *rev_cooldown;
+    int    *bto_brake, *bto_min;
+    double *gain[6], *cc_kp, *idle_kp, *bto_scale;
+
+    // state
+    int *speed, *limp, *overlap, *hard, *cooldown;
+
+    // summary
+    int       *speed_max;
+    long long *speed_sum, *limp_rows, *cut_rows;
+
+    void *mem;
+} lanes_t;
+
+static int lanes_alloc(lanes_t *L, int n) {
+    memset(L, 0, sizeof(*L));
+    int **ints[] = {
+        &L->max, &L->brake_gain, &L->cc_gear_min, &L->cc_tmin, &L->cc_thi, &L->cc_step,
+        &L->drag, &L->idle_gear_max, &L->idle_target, &L->idle_step,
+        &L->slew_rise, &L->slew_fall, &L->acc_ovl, &L->brk_ovl, &L->limp_need, &L->limp_cap, &L->limp_clear,
+        &L->rev_soft, &L->rev_hard, &L->rev_hyst, &L->rev_step, &L->rev_cooldown,
+        &L->bto_brake, &L->bto_min,
+        &L->speed, &L->limp, &L->overlap, &L->hard, &L->cooldown, &L->speed_max
+    };
+    double **dbls[] = {
+        &L->gain[0], &L->gain[1], &L->gain[2], &L->gain[3], &L->gain[4], &L->gain[5],
+        &L->cc_kp, &L->idle_kp, &L->bto_scale
+    };
+    long long **lls[] = { &L->speed_sum, &L->limp_rows, &L->cut_rows };
+    const size_t nint = sizeof(ints) / sizeof(ints[0]);
+    const size_t ndbl = sizeof(dbls) / sizeof(dbls[0]);
+    const size_t nll  = sizeof(lls) / sizeof(lls[0]);
+
+    // Every column starts on a 64-byte boundary.
+    size_t stride = ((size_t)n + 15) & ~(size_t)15;
+    size_t bytes = stride * (nint * sizeof(int) + ndbl * sizeof(double) + nll * sizeof(long long));
+    L->mem = aligned_alloc(64, bytes);
+    if (!L->mem) return -1;
+    memset(L->mem, 0, bytes);
+    L->n = n;
+
+    char *p = L->mem;
+    for (size_t k = 0; k < ndbl; k++) { *dbls[k] = (double *)p;    p += stride * sizeof(double); }
+    for (size_t k = 0; k < nll; k++)  { *lls[k]  = (long long *)p; p += stride * sizeof(long long); }
+    for (size_t k = 0; k < nint; k++) { *ints[k] = (int *)p;       p += stride * sizeof(int); }
+    return 0;
+}
+
+static void lanes_load(lanes_t *L, int i, const ecu_calib_t *c) {
+    L->max[i]           = c->max_engine_speed;
+    L->brake_gain[i]    = c->brake_gain_rpm_per_deg;
+    L->cc_gear_min[i]   = c->cc_activation_gear_min;
+    L->cc_tmin[i]       = c->cc_target_min;
+    L->cc_thi[i]        = c->run.cc_target_hi;
+    L->cc_step[i]       = c->cc_max_step_per_iter;
+    L->drag[i]          = c->run.drag;
+    L->idle_gear_max[i] = c->idle_activation_gear_max;
+    L->idle_target[i]   = c->idle_target_speed;
+    L->idle_step[i]     = c->idle_max_step_per_iter;
+    L->slew_rise[i]     = c->run.slew_rise;
+    L->slew_fall[i]     = c->run.slew_fall;
+    L->acc_ovl[i]       = c->run.acc_overlap;
+    L->brk_ovl[i]       = c->run.brk_overlap;
+    L->limp_need[i]     = c->run.limp_need;
+    L->limp_cap[i]      = c->run.limp_cap;
+    L->limp_clear[i]    = c->limp_clear_on_ignition_off ? 1 : 0;
+    L->rev_soft[i]      = c->run.rev_soft;
+    L->rev_hard[i]      = c->run.rev_hard;
+    L->rev_hyst[i]      = c->run.rev_hysteresis;
+    L->rev_step[i]      = c->run.rev_cut_step;
+    L->rev_cooldown[i]  = c->run.rev_cooldown;
+    L->bto_brake[i]     = c->run.bto_brake;
+    L->bto_min[i]       = c->run.bto_acc_min;
+    for (int g = 0; g < 6; g++) L->gain[g][i] = c->run.acc_gain[g];
+    L->cc_kp[i]         = c->cc_kp;
+    L->idle_kp[i]       = c->idle_kp;
+    L->bto_scale[i]     = c->run.bto_scale;
+}
+
+static inline int imin(int a, int b) { return a < b ? a : b; }
+static inline int imax(int a, int b) { return a > b ? a : b; }
+// Branch-free select on a 0/1 flag. Plain ?: lets the compiler sink the
+// unused arm's loads and FP ops behind a branch, which blocks if-conversion.
+static inline int blend(int m, int a, int b) { return b ^ ((a ^ b) & -m); }
+
+// round_to_int() for x >= 0: every rounded speed is clamped at 0 first.
+static inline int round_nonneg(double x) { return (int)(x + 0.5); }
+// round_to_int() for either sign (half away from zero), without a branch:
+// the idle correction is negative when idle_max_step_per_iter is.
+static inline int round_half_away(double x) { return (int)(x + copysign(0.5, x)); }
+
+// Ignition OFF: same resets as ecu_step(), for every lane.
+static void sweep_row_off(lanes_t *L) {
+    for (int i = 0; i < L->n; i++) {
+        L->limp[i]    = L->limp_clear[i] ? 0 : L->limp[i];
+        L->overlap[i] = L->limp_clear[i] ? 0 : L->overlap[i];
+        L->hard[i]     = 0;
+        L->cooldown[i] = 0;
+        L->speed[i]    = 0;
+    }
+}
+
+// Ignition ON: ecu_step() written branch-free across lanes. The inputs are
+// shared (already clamped); only calibration and state differ per lane.
+// Every column is read unconditionally so the loop if-converts and
+// vectorises; the AVX2 clone runs 8 int / 4 double lanes per instruction.
+SWEEP_KERNEL
+static void sweep_row_on(lanes_t *L, int acc, int brake, int gear, int cc_en, int cc_tgt) {
+    const int n = L->n;
+    const int    *restrict max_c = L->max,         *restrict bgain_c = L->brake_gain;
+    const int    *restrict ccg_c = L->cc_gear_min, *restrict tmin_c = L->cc_tmin, *restrict thi_c = L->cc_thi;
+    const int    *restrict ccs_c = L->cc_step,     *restrict drag_c = L->drag;
+    const int    *restrict igm_c = L->idle_gear_max, *restrict itg_c = L->idle_target, *restrict ist_c = L->idle_step;
+    const int    *restrict rise_c = L->slew_rise,  *restrict fall_c = L->slew_fall;
+    const int    *restrict aov_c = L->acc_ovl,     *restrict bov_c = L->brk_ovl;
+    const int    *restrict need_c = L->limp_need,  *restrict cap_c = L->limp_cap;
+    const int    *restrict soft_c = L->rev_soft,   *restrict hard_c = L->rev_hard, *restrict hyst_c = L->rev_hyst;
+    const int    *restrict rstep_c = L->rev_step,  *restrict rcool_c = L->rev_cooldown;
+    const int    *restrict btob_c = L->bto_brake,  *restrict btom_c = L->bto_min;
+    const double *restrict gain_c = L->gain[gear], *restrict kp_c = L->cc_kp, *restrict ikp_c = L->idle_kp;
+    const double *restrict scale_c = L->bto_scale;
+    int *restrict speed = L->speed, *restrict limp = L->limp, *restrict overlap = L->overlap;
+    int *restrict hard = L->hard, *restrict cooldown = L->cooldown;
+
+    const int no_brake_cc_off = (brake == 0) & (cc_en == 0);
+    const int cruise_req = (cc_en == 1) & (brake == 0);
+
+    // Lanes are independent: each iteration touches only column [i].
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (int i = 0; i < n; i++) {
+        const int max  = max_c[i];
+        const int prev = speed[i];
+        const int tmin = tmin_c[i], thi = thi_c[i];
+        const int rise = rise_c[i], fall = fall_c[i];
+        const int cap  = cap_c[i],  rh = hard_c[i], rcool = rcool_c[i];
+        const double cc_step = (double)ccs_c[i], idle_step = (double)ist_c[i];
+
+        // SCR9 plausibility
+        int ov  = (acc >= aov_c[i]) & (brake >= bov_c[i]);
+        int oc  = overlap[i];
+        int cnt = ov ? oc + 1 : 0;
+        int lm  = limp[i] | (cnt >= need_c[i]);
+        overlap[i] = cnt;
+        limp[i] = lm;
+
+        // SCR11 BTO
+        int bto = (brake >= btob_c[i]) & (acc >= btom_c[i]);
+        int scaled = imax(0, imin(45, round_nonneg((double)acc * scale_c[i])));
+        int eff = blend(bto, scaled, acc);
+
+        // SCR2..SCR5: both the plain and the cruise result, then pick
+        double next = (double)prev + (double)eff * gain_c[i] - (double)brake * (double)bgain_c[i];
+        int target = cc_tgt < tmin ? tmin : (cc_tgt > thi ? thi : cc_tgt);
+        double dcc = kp_c[i] * ((double)target - (double)prev);
+        double dcc_hi = dcc > cc_step ? cc_step : dcc;
+        double dcc_lim = dcc_hi < -cc_step ? -cc_step : dcc_hi;
+        double next_cc = next + dcc_lim;
+        double lo_plain = next < 0.0 ? 0.0 : next;
+        double lo_cc = next_cc < 0.0 ? 0.0 : next_cc;
+        int s_plain = round_nonneg(lo_plain > (double)max ? (double)max : lo_plain);
+        int s_cc    = round_nonneg(lo_cc > (double)max ? (double)max : lo_cc);
+        int cruise_ok = cruise_req & (eff == 0) & (gear >= ccg_c[i]);
+        int s = blend(cruise_ok, s_cc, s_plain);
+
+        // SCR6 coastdown + SCR7 idle
+        int coast = no_brake_cc_off & (eff == 0);
+        int s_drag = imax(0, imin(max, s - drag_c[i]));
+        double didle = ikp_c[i] * (double)(itg_c[i] - prev);
+        double didle_lo = didle < 0.0 ? 0.0 : didle;
+        double didle_cl = didle_lo > idle_step ? idle_step : didle_lo;
+        int s_idle = imax(0, imin(max, s_drag + round_half_away(didle_cl)));
+        int idle_ok = coast & (gear <= igm_c[i]) & (prev < itg_c[i]);
+        s = blend(coast, blend(idle_ok, s_idle, s_drag), s);
+
+        // SCR9 cap
+        s = blend(lm & (s > cap), cap, s);
+
+        // SCR10 rev limiter
+        int h = hard[i], cd = cooldown[i];
+        int cd_dec   = imax(cd, 1) - 1;
+        int s_active = imin(s, prev - rstep_c[i]);
+        int release  = (prev <= rh - hyst_c[i]) & (cd_dec == 0);
+        int trig     = (s > rh) | (prev > rh);
+        hard[i]     = blend(h, !release, trig);
+        cooldown[i] = blend(h, cd_dec, blend(trig, rcool, cd));
+        s = blend(h, s_active, blend(trig, imin(s, rh), s));
+        s = imin(s, soft_c[i]);
+        s = imax(0, imin(max, s));
+
+        // SCR8 slew
+        int d = s - prev;
+        s = blend(d > rise, prev + rise, blend(d < -fall, prev - fall, s));
+        speed[i] = imax(0, imin(max, s));
+    }
+}
+
+// One input row for every lane; returns its engine_state. Pedals and gear
+// are clamped as ecu_step() does.
+static int sweep_row(lanes_t *L, int ign, int acc, int brake, int gear, int cc_en, int cc_tgt) {
+    int es = compute_engine_state(ign);
+    if (es == 0) {
+        sweep_row_off(L);
+    } else {
+        acc   = acc   < 0 ? 0 : (acc   > 45 ? 45 : acc);
+        brake = brake < 0 ? 0 : (brake > 45 ? 45 : brake);
+        gear  = gear  < 1 ? 1 : (gear  > 5  ? 5  : gear);
+        sweep_row_on(L, acc, brake, gear, cc_en, cc_tgt);
+    }
+    return es;
+}
+
+static void sweep_accumulate(lanes_t *L) {
+    for (int i = 0; i < L->n; i++) {
+        L->speed_max[i] = imax(L->speed_max[i], L->speed[i]);
+        L->speed_sum[i] += L->speed[i];
+        L->limp_rows[i] += L->limp[i];
+        L->cut_rows[i]  += L->hard[i];
+    }
+}
+
+// ---------- Variant construction ----------
+static int is_regular_file(const char *path) {
+    struct stat sb;
+    return stat(path, &sb) == 0 && S_ISREG(sb.st_mode);
+}
+
+static int push_variant(variant_t **v, int *count, int *cap, const ecu_calib_t *cal, const char *name) {
+    if (*count >= SWEEP_MAX_VARIANTS) return -1;
+    if (*count == *cap) {
+        int ncap = *cap ? *cap * 2 : 64;
+        variant_t *nv = realloc(*v, (size_t)ncap * sizeof(**v));
+        if (!nv) return -1;
+        *v = nv; *cap = ncap;
+    }
+    (*v)[*count].cal = *cal;
+    snprintf((*v)[*count].name, sizeof((*v)[*count].name), "%s", name);
+    (*count)++;
+    return 0;
+}
+
+static int variants_from_manifest(const char *manifest, variant_t **v, int *count) {
+    FILE *f = fopen(manifest, "r");
+    if (!f) return -1;
+    int cap = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = trace_manifest_entry(line);
+        if (!p) continue;
+
+        ecu_calib_t cal;
+        if (ecu_calib_load(p, &cal, stderr) < 0) {
+            fprintf(stderr, "sweep: cannot open calibration %s\n", p);
+            fclose(f);
+            return -1;
+        }
+        const char *base = strrchr(p, '/');
+        base = base ? base + 1 : p;
+        char name[128];
+        snprintf(name, sizeof(name), "%s", base);
+        char *dot = strrchr(name, '.');
+        if (dot && dot != name) *dot = '\0';
+        if (push_variant(v, count, &cap, &cal, name) != 0) { fclose(f); return -1; }
+    }
+    fclose(f);
+    return 0;
+}
+
+static void append(char *dst, size_t cap, const char *src) {
+    size_t n = strlen(dst);
+    while (*src && n + 1 < cap) dst[n++] = *src++;
+    dst[n] = '\0';
+}
+
+typedef struct {
+    char   key[64];
+    double start, stop, step;
+    int    steps;
+} axis_t;
+
+static int variants_from_grid(const ecu_calib_t *base, const char *spec, variant_t **v, int *count) {
+    axis_t axes[SWEEP_MAX_AXES];
+    int naxes = 0;
+    long total = 1;
+
+    const char *p = spec;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        char item[256];
+        if (len >= sizeof(item) || naxes == SWEEP_MAX_AXES) return -1;
+        memcpy(item, p, len);
+        item[len] = '\0';
+
+        axis_t *a = &axes[naxes];
+        char *eq = strchr(item, '=');
+        if (!eq || (size_t)(eq - item) >= sizeof(a->key)) return -1;
+        *eq = '\0';
+        memcpy(a->key, item, (size_t)(eq - item) + 1);
+        int got = sscanf(eq + 1, "%lf:%lf:%lf", &a->start, &a->stop, &a->step);
+        if (got == 1) { a->stop = a->start; a->step = 1.0; }
+        else if (got != 3 || a->step <= 0.0 || a->stop < a->start) return -1;
+        a->steps = (int)((a->stop - a->start) / a->step + 1e-9) + 1;
+        total *= a->steps;
+        if (total > SWEEP_MAX_VARIANTS) return -1;
+        naxes++;
+        p = end ? end + 1 : p + len;
+    }
+    if (naxes == 0) return -1;
+
+    int cap = 0;
+    for (long k = 0; k < total; k++) {
+        ecu_calib_t cal = *base;
+        char name[128] = "";
+        long rem = k;
+        int idx[SWEEP_MAX_AXES];
+        for (int a = naxes - 1; a >= 0; a--) {   // last axis varies fastest
+            idx[a] = (int)(rem % axes[a].steps);
+            rem /= axes[a].steps;
+        }
+        for (int a = 0; a < naxes; a++) {
+            char val[32];
+            snprintf(val, sizeof(val), "%.10g", axes[a].start + idx[a] * axes[a].step);
+            if (ecu_calib_set(&cal, axes[a].key, val) != 0) {
+                fprintf(stderr, "sweep: cannot set '%s' to %s\n", axes[a].key, val);
+                return -1;
+            }
+            if (a) append(name, sizeof(name), "/");
+            append(name, sizeof(name), axes[a].key);
+            append(name, sizeof(name), "=");
+            append(name, sizeof(name), val);
+        }
+        if (push_variant(v, count, &cap, &cal, name) != 0) return -1;
+    }
+    return 0;
+}
+
+// ---------- Single variant ----------
+int sweep_run_rows(const ecu_calib_t *cal, const ecu_input_t *in, size_t n,
+                   int *engine_state, int *engine_speed)
+{
+    lanes_t L;
+    if (lanes_alloc(&L, 1) != 0) return -1;
+    lanes_load(&L, 0, cal);
+    for (size_t i = 0; i < n; i++) {
+        engine_state[i] = sweep_row(&L, in[i].ignition_switch, in[i].acc_pedal_position,
+                                    in[i].brake_pedal_position, in[i].current_gear,
+                                    in[i].cruise_enable, in[i].cruise_target_speed);
+        engine_speed[i] = L.speed[0];
+    }
+    free(L.mem);
+    return 0;
+}
+
+// ---------- Driver ----------
+int sweep_run(const ecu_calib_t *base,
+              const char *spec,
+              const char *in_path,
+              const char *out_path,
+              FILE *report)
+{
+    variant_t *v = NULL;
+    int nv = 0;
+    int rc = is_regular_file(spec) ? variants_from_manifest(spec, &v, &nv)
+                                   : variants_from_grid(base, spec, &v, &nv);
+    if (rc != 0 || nv == 0) {
+        fprintf(stderr, "sweep: bad variant spec '%s'\n", spec);
+        free(v);
+        return 2;
+    }
+
+    lanes_t L;
+    if (lanes_alloc(&L, nv) != 0) { free(v); return 2; }
+    for (int i = 0; i < nv; i++) lanes_load(&L, i, &v[i].cal);
+
+    trace_reader_t *r;
+    rc = trace_open(in_path, &r);
+    if (rc) { free(L.mem); free(v); return rc; }
+
+    writer_t *fout = NULL;
+    if (out_path) {
+        fout = writer_open(out_path, WRITER_FLUSH_BATCH);
+        if (!fout) {
+            fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno));
+            trace_close(r); free(L.mem); free(v);
+            return 4;
+        }
+        writer_str(fout, "time,engine_state");
+        for (int i = 0; i < nv; i++) { writer_char(fout, ','); writer_str(fout, v[i].name); }
+        writer_row_end(fout);
+    }
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) { trace_close(r); if (fout) writer_close(fout); free(L.mem); free(v); return 2; }
+
+    while (trace_read_block(r, blk) > 0) {
+        for (size_t k = 0; k < blk->n; k++) {
+            for (int rep = 0; rep < blk->rep[k]; rep++) {  // 'repeat' rows
+                int es = sweep_row(&L, blk->ign[k], blk->acc[k], blk->brk[k], blk->gear[k],
+                                   blk->cc_en[k], blk->cc_tgt[k]);
+                sweep_accumulate(&L);
+
+                if (fout) {
+                    writer_i64(fout, blk->t[k] + rep);
+                    writer_char(fout, ',');
+                    writer_i64(fout, es);
+                    for (int i = 0; i < nv; i++) { writer_char(fout, ','); writer_i64(fout, L.speed[i]); }
+                    writer_row_end(fout);
+                }
+            }
+        }
+    }
+
+    long rows = trace_rows(r);
+    if (trace_failed(r)) rc = 3;
+    if (report) {
+        fprintf(report, "variant,max_speed,mean_speed,final_speed,limp_rows,hard_cut_rows\n");
+        for (int i = 0; i < nv; i++) {
+            fprintf(report, "%s,%d,%.2f,%d,%lld,%lld\n", v[i].name, L.speed_max[i],
+                    rows ? (double)L.speed_sum[i] / (double)rows : 0.0,
+                    L.speed[i], L.limp_rows[i], L.cut_rows[i]);
+        }
+    }
+
+    free(blk);
+    trace_close(r);
+    if (fout && writer_close(fout) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        rc = 4;
+    }
+    free(L.mem);
+    free(v);
+    return rc;
+}
@@ -0,0 +1,709 @@
+// app/c_files/trace_io.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "trace_io.h"
+#include "ecub.h"
+#include "zio.h"
+
+#define READ_CHUNK (1 << 16)
+
+// A field or line inside the input bytes; never NUL-terminated.
+typedef struct {
+    const char *p;
+    size_t      n;
+} span_t;
+
+// CSV columns the reader decodes, by header name.
+enum { F_TIME, F_IGN, F_ACC, F_BRK, F_GEAR, F_CC_EN, F_CC_TGT, F_REP, F_COUNT };
+static const char *const FIELD_NAME[F_COUNT] = {
+    "time", "ignition_switch", "acc_pedal_position", "brake_pedal_position",
+    "current_gear", "cruise_enable", "cruise_target_speed", "repeat"
+};
+
+// One needed column: where it is in the row and which F_* it feeds.
+typedef struct {
+    int col;
+    int field;
+} proj_t;
+
+struct trace_reader {
+    int fd;
+    const char *path;
+    long tgen;
+    int field_col[F_COUNT];     // column of each F_*, -1 = absent
+    proj_t proj[F_COUNT];       // the present ones, by column
+    int nproj;
+
+    // Regular files are mapped and walked in place; pipes and anything that
+    // cannot be mapped go through a growable read() buffer instead.
+    int    mapped;
+    char  *map;
+    size_t map_len;
+    char  *buf;
+    size_t buf_cap;
+    int    eof;
+    int    own_fd;          // 0 when reading stdin ("-")
+    int    hold_partial;    // leave an unterminated last line unread
+    int64_t buf_off;        // file offset of buf[0] (read() mode)
+    uint64_t header_hash;
+    int64_t fill_ns;        // CLOCK_MONOTONIC when read() last returned data
+
+    // Compressed inputs: read() mode fed by the decompression thread; a
+    // mapped file stays mapped as its compressed source.
+    zin_t *z;
+    int    z_corrupt;
+
+    const char *cur;        // next unread byte
+    const char *end;        // end of valid bytes
+
+    // Binary (.ecub) inputs: columns point straight into the mapping.
+    ecub_reader_t *bin;
+    const void   **bin_cols;
+    int            bin_idx[7];     // ECUB_INPUT_SCHEMA order, -1 = default
+    size_t         bin_rows;       // rows in the current ecub block
+    size_t         bin_pos;        // rows of it already handed out
+    int            bin_corrupt;
+    int           *bin_dflt[7];    // default-filled stand-ins
+    int64_t       *bin_time;
+};
+
+_Static_assert(sizeof(int) == sizeof(int32_t), "ecub int32 columns feed int arrays");
+
+static int reader_init(trace_reader_t *r) {
+#ifndef _WIN32
+    struct stat sb;
+    if (fstat(r->fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        void *m = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+        if (m != MAP_FAILED) {
+            madvise(m, (size_t)sb.st_size, MADV_SEQUENTIAL);
+            r->mapped  = 1;
+            r->map     = m;
+            r->map_len = (size_t)sb.st_size;
+            r->cur     = r->map;
+            r->end     = r->map + r->map_len;
+            r->eof     = 1;
+            return 0;
+        }
+    }
+#endif
+    r->buf_cap = READ_CHUNK;
+    r->buf = malloc(r->buf_cap);
+    if (!r->buf) return -1;
+    r->cur = r->end = r->buf;
+    return 0;
+}
+
+static void stamp_fill(trace_reader_t *r) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    r->fill_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Buffered mode: keep the unread tail, grow if one line fills the buffer,
+// and read() whatever is available. Returns 0 at EOF.
+static int reader_fill(trace_reader_t *r) {
+    if (r->eof) return 0;
+    size_t keep = (size_t)(r->end - r->cur);
+    r->buf_off += r->cur - r->buf;
+    if (keep && r->cur != r->buf) memmove(r->buf, r->cur, keep);
+    if (keep == r->buf_cap) {
+        char *nb = realloc(r->buf, r->buf_cap * 2);
+        if (!nb) { r->eof = 1; return 0; }
+        r->buf = nb;
+        r->buf_cap *= 2;
+    }
+    r->cur = r->buf;
+    r->end = r->buf + keep;
+
+    ssize_t got;
+    if (r->z) {
+        got = zin_read(r->z, r->buf + keep, r->buf_cap - keep);
+        if (got < 0) r->z_corrupt = 1;
+    } else {
+        do {
+            got = read(r->fd, r->buf + keep, r->buf_cap - keep);
+        } while (got < 0 && errno == EINTR);
+    }
+    if (got <= 0) { r->eof = 1; return 0; }
+    stamp_fill(r);
+    r->end += got;
+    return 1;
+}
+
+// A complete line (or the final unterminated one) is already buffered.
+static int line_ready(const trace_reader_t *r) {
+    return memchr(r->cur, '\n', (size_t)(r->end - r->cur)) != NULL ||
+           (r->eof && r->cur < r->end && !r->hold_partial);
+}
+
+// Next line without its terminator ('\n', optional '\r'). Returns 0 at EOF.
+static int next_line(trace_reader_t *r, span_t *line) {
+    for (;;) {
+        const char *nl = memchr(r->cur, '\n', (size_t)(r->end - r->cur));
+        if (nl || (r->eof && r->cur < r->end && !r->hold_partial)) {
+            const char *stop = nl ? nl : r->end;
+            line->p = r->cur;
+            line->n = (size_t)(stop - r->cur);
+            if (line->n && line->p[line->n - 1] == '\r') line->n--;
+            r->cur = nl ? nl + 1 : r->end;
+            return 1;
+        }
+        if (!reader_fill(r)) {
+            if (r->cur < r->end && !r->hold_partial) continue;   // unterminated last line
+            return 0;
+        }
+    }
+}
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+
+static uint64_t fnv1a(uint64_t h, const char *p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// ======================== Column projection ========================
+// The header is compiled once into the list of needed columns; rows are
+// then walked only as far as the last of them, and the columns between
+// are skipped by counting commas, eight bytes at a time.
+
+// Records the column of every F_* name in the header (first one wins).
+static void compile_header(trace_reader_t *r, span_t line) {
+    for (int f = 0; f < F_COUNT; f++) r->field_col[f] = -1;
+    const char *p = line.p, *end = line.p + line.n;
+    for (int col = 0; ; col++) {
+        const char *c = memchr(p, ',', (size_t)(end - p));
+        size_t n = (size_t)((c ? c : end) - p);
+        for (int f = 0; f < F_COUNT; f++) {
+            if (r->field_col[f] < 0 && strlen(FIELD_NAME[f]) == n && memcmp(p, FIELD_NAME[f], n) == 0) {
+                r->field_col[f] = col;
+            }
+        }
+        if (!c) break;
+        p = c + 1;
+    }
+
+    r->nproj = 0;
+    for (int f = 0; f < F_COUNT; f++) {
+        if (r->field_col[f] < 0) continue;
+        int k = r->nproj++;
+        while (k > 0 && r->proj[k - 1].col > r->field_col[f]) { r->proj[k] = r->proj[k - 1]; k--; }
+        r->proj[k].col = r->field_col[f];
+        r->proj[k].field = f;
+    }
+}
+
+// Start of the field k commas after p, or NULL if the line ends first.
+static const char *skip_fields(const char *p, const char *end, int k) {
+    const uint64_t lo7 = 0x7f7f7f7f7f7f7f7fULL;
+    while (end - p >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        uint64_t x = w ^ 0x2c2c2c2c2c2c2c2cULL;            // ',' bytes -> 0
+        uint64_t zero = ~(((x & lo7) + lo7) | x | lo7);     // 0x80 per zero byte, exact
+        int commas = __builtin_popcountll(zero);
+        if (commas >= k) break;
+        k -= commas;
+        p += 8;
+    }
+    for (; p < end; p++) {
+        if (*p == ',' && --k == 0) return p + 1;
+    }
+    return NULL;
+}
+
+// Fills f[F_*] with the needed fields of line; absent ones stay empty.
+static void project_row(const trace_reader_t *r, span_t line, span_t f[F_COUNT]) {
+    for (int i = 0; i < F_COUNT; i++) f[i].n = 0;
+    const char *p = line.p, *end = line.p + line.n;
+    int col = 0;
+    for (int k = 0; k < r->nproj; k++) {
+        const proj_t *pj = &r->proj[k];
+        if (pj->col > col) {
+            p = skip_fields(p, end, pj->col - col);
+            if (!p) return;
+            col = pj->col;
+        }
+        const char *c = memchr(p, ',', (size_t)(end - p));
+        f[pj->field].p = p;
+        f[pj->field].n = (size_t)((c ? c : end) - p);
+        if (!c) return;
+        p = c + 1;
+        col++;
+    }
+}
+
+// strtol(field, NULL, 10) on a span: leading space, sign, digits, saturating.
+static long span_to_long(span_t f) {
+    const char *p = f.p, *end = f.p + f.n;
+    while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) p++;
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+    unsigned long v = 0, lim = neg ? (unsigned long)LONG_MAX + 1UL : (unsigned long)LONG_MAX;
+    int over = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        unsigned d = (unsigned)(*p - '0');
+        if (v > (lim - d) / 10) { over = 1; continue; }
+        v = v * 10 + d;
+    }
+    if (over) return neg ? LONG_MIN : LONG_MAX;
+    return neg ? (long)(0UL - v) : (long)v;
+}
+
+ecu_columns_t trace_block_columns(const trace_block_t *blk) {
+    ecu_columns_t cols = { blk->ign, blk->acc, blk->brk, blk->gear, blk->cc_en, blk->cc_tgt };
+    return cols;
+}
+
+// Maps the input schema onto the file's columns; missing ones get a
+// TRACE_BLOCK_ROWS array of their default.
+static int bin_init(trace_reader_t *r) {
+    if (ecub_open_mem(r->map, r->map_len, r->path, &r->bin) != 0) return 6;
+    r->bin_cols = calloc((size_t)ecub_ncols(r->bin), sizeof(*r->bin_cols));
+    if (!r->bin_cols) return 3;
+
+    for (int i = 0; i < 7; i++) {
+        const ecub_col_desc_t *want = &ECUB_INPUT_SCHEMA[i];
+        int idx = ecub_col(r->bin, want->name);
+        if (idx >= 0 && ecub_desc(r->bin, idx)->type != want->type) {
+            fprintf(stderr, "%s: column '%s' has the wrong type\n", r->path, want->name);
+            return 6;
+        }
+        r->bin_idx[i] = idx;
+        if (idx >= 0) continue;
+        if (i == 1) {
+            fprintf(stderr, "%s: input schema must contain 'ignition_switch'\n", r->path);
+            return 6;
+        }
+        if (i == 0) {
+            r->bin_time = malloc(TRACE_BLOCK_ROWS * sizeof(*r->bin_time));
+            if (!r->bin_time) return 3;
+            continue;
+        }
+        r->bin_dflt[i] = malloc(TRACE_BLOCK_ROWS * sizeof(int));
+        if (!r->bin_dflt[i]) return 3;
+        int dflt = (i == 4) ? 3 : 0;
+        for (int k = 0; k < TRACE_BLOCK_ROWS; k++) r->bin_dflt[i][k] = dflt;
+    }
+    return 0;
+}
+
+// gzip / zstd input, told by its magic: from here on reader_fill() takes
+// decompressed bytes from the inflating thread instead of read().
+static int open_compressed(trace_reader_t *r) {
+    zio_format_t f;
+    if (r->mapped) {
+        f = zio_detect(r->map, r->map_len);
+    } else {
+        while (!r->eof && r->end - r->cur < 4) reader_fill(r);
+        f = zio_detect(r->cur, (size_t)(r->end - r->cur));
+    }
+    if (f == ZIO_NONE) return 0;
+    if (!zio_supported(f)) {
+        fprintf(stderr, "%s: %s-compressed input needs a build with %s\n", r->path, zio_name(f),
+                f == ZIO_GZIP ? "ECU_WITH_ZLIB (make ZLIB=1)" : "ECU_WITH_ZSTD (make ZSTD=1)");
+        return 3;
+    }
+
+    if (r->mapped) {
+        r->z = zin_open(f, r->map, r->map_len, -1);
+        r->mapped = 0;
+        r->buf_cap = READ_CHUNK;
+        r->buf = malloc(r->buf_cap);
+        if (!r->buf) return 3;
+    } else {
+        r->z = zin_open(f, r->cur, (size_t)(r->end - r->cur), r->fd);
+    }
+    if (!r->z) {
+        fprintf(stderr, "%s: cannot start %s decompression\n", r->path, zio_name(f));
+        return 3;
+    }
+    r->cur = r->end = r->buf;
+    r->buf_off = 0;
+    r->eof = 0;
+
+    // .ecub readers walk a mapping; a compressed one has none to walk.
+    while (!r->eof && r->end - r->cur < 4) reader_fill(r);
+    if (r->end - r->cur >= 4 && memcmp(r->cur, ECUB_MAGIC, 4) == 0) {
+        fprintf(stderr, "%s: compressed .ecub input is not supported\n", r->path);
+        return 6;
+    }
+    return 0;
+}
+
+int trace_open(const char *path, trace_reader_t **out) {
+    *out = NULL;
+    trace_reader_t *r = calloc(1, sizeof(*r));
+    if (!r) return 3;
+    r->path = path;
+
+    r->own_fd = strcmp(path, "-") != 0;
+    r->fd = r->own_fd ? open(path, O_RDONLY) : STDIN_FILENO;
+    if (r->fd < 0) { fprintf(stderr, "open input %s: %s\n", path, strerror(errno)); free(r); return 3; }
+    if (reader_init(r) != 0) { trace_close(r); return 3; }
+    int rc = open_compressed(r);
+    if (rc) { trace_close(r); return rc; }
+
+    if (r->mapped && ecub_is(r->map, r->map_len)) {
+        rc = bin_init(r);
+        if (rc) { trace_close(r); return rc; }
+        *out = r;
+        return 0;
+    }
+
+    // --- Header ---
+    span_t line;
+    if (!next_line(r, &line)) {
+        int corrupt = r->z_corrupt;
+        fprintf(stderr, "%s: %s\n", path, corrupt ? "corrupt compressed input" : "empty input");
+        trace_close(r);
+        return corrupt ? 3 : 5;
+    }
+    r->header_hash = fnv1a(FNV_OFFSET, line.p, line.n);
+    compile_header(r, line);
+
+    if (r->field_col[F_IGN] < 0) {
+        fprintf(stderr, "%s: input header must contain 'ignition_switch'\n", path);
+        trace_close(r);
+        return 6;
+    }
+    *out = r;
+    return 0;
+}
+
+static int field_int(span_t f, int dflt) {
+    return f.n ? (int)span_to_long(f) : dflt;
+}
+
+int trace_has_repeat(const trace_reader_t *r) {
+    return !r->bin && r->field_col[F_REP] >= 0;
+}
+
+int trace_is_binary(const trace_reader_t *r) {
+    return r->bin != NULL;
+}
+
+static const int *bin_col(const trace_reader_t *r, int i) {
+    return r->bin_idx[i] >= 0 ? (const int *)r->bin_cols[r->bin_idx[i]] + r->bin_pos : r->bin_dflt[i];
+}
+
+size_t trace_view_next(trace_reader_t *r, trace_view_t *v) {
+    v->n = 0;
+    if (!r->bin) return 0;
+    while (r->bin_pos == r->bin_rows) {
+        long n = ecub_next(r->bin, r->bin_cols);
+        if (n <= 0) { r->bin_corrupt = (n < 0); return 0; }
+        r->bin_rows = (size_t)n;
+        r->bin_pos = 0;
+    }
+    size_t n = r->bin_rows - r->bin_pos;
+    if (n > TRACE_BLOCK_ROWS) n = TRACE_BLOCK_ROWS;
+
+    if (r->bin_idx[0] >= 0) {
+        v->t = (const int64_t *)r->bin_cols[r->bin_idx[0]] + r->bin_pos;
+    } else {
+        for (size_t k = 0; k < n; k++) r->bin_time[k] = r->tgen + (int64_t)k;
+        v->t = r->bin_time;
+    }
+    v->in.ignition_switch      = bin_col(r, 1);
+    v->in.acc_pedal_position   = bin_col(r, 2);
+    v->in.brake_pedal_position = bin_col(r, 3);
+    v->in.current_gear         = bin_col(r, 4);
+    v->in.cruise_enable        = bin_col(r, 5);
+    v->in.cruise_target_speed  = bin_col(r, 6);
+    v->n = n;
+
+    r->bin_pos += n;
+    r->tgen += (long)n;
+    return n;
+}
+
+static size_t decode_rows(trace_reader_t *r, trace_block_t *blk, int ready_only);
+
+size_t trace_read_block(trace_reader_t *r, trace_block_t *blk) {
+    if (r->bin) {
+        trace_view_t v;
+        blk->n = trace_view_next(r, &v);
+        size_t bytes = blk->n * sizeof(int);
+        memcpy(blk->t,      v.t,                         blk->n * sizeof(*blk->t));
+        memcpy(blk->ign,    v.in.ignition_switch,        bytes);
+        memcpy(blk->acc,    v.in.acc_pedal_position,     bytes);
+        memcpy(blk->brk,    v.in.brake_pedal_position,   bytes);
+        memcpy(blk->gear,   v.in.current_gear,           bytes);
+        memcpy(blk->cc_en,  v.in.cruise_enable,          bytes);
+        memcpy(blk->cc_tgt, v.in.cruise_target_speed,    bytes);
+        for (size_t i = 0; i < blk->n; i++) blk->rep[i] = 1;
+        return blk->n;
+    }
+
+    return decode_rows(r, blk, 0);
+}
+
+size_t trace_read_ready(trace_reader_t *r, trace_block_t *blk) {
+    // A mapped file arrived whole: time each block from when it is asked for.
+    if (r->mapped && !r->z) stamp_fill(r);
+    return decode_rows(r, blk, 1);
+}
+
+int64_t trace_ready_ns(const trace_reader_t *r) {
+    return r->fill_ns;
+}
+
+// ready_only: stop at the first row not yet received instead of blocking.
+static size_t decode_rows(trace_reader_t *r, trace_block_t *blk, int ready_only) {
+    size_t nb = 0;
+    span_t line;
+    while (nb < TRACE_BLOCK_ROWS) {
+        if (ready_only && nb > 0 && !line_ready(r)) break;
+        if (!next_line(r, &line)) break;
+        if (line.n == 0) continue;
+        span_t f[F_COUNT];
+        project_row(r, line, f);
+
+        int rep = field_int(f[F_REP], 1);
+        if (rep < 1) rep = 1;
+        blk->rep[nb] = rep;
+
+        int64_t t = r->tgen;
+        r->tgen += rep;
+        if (f[F_TIME].n) t = span_to_long(f[F_TIME]);
+        blk->t[nb] = t;
+
+        blk->ign[nb]    = field_int(f[F_IGN], 0);
+        blk->acc[nb]    = field_int(f[F_ACC], 0);
+        blk->brk[nb]    = field_int(f[F_BRK], 0);
+        blk->gear[nb]   = field_int(f[F_GEAR], 3);
+        blk->cc_en[nb]  = field_int(f[F_CC_EN], 0);
+        blk->cc_tgt[nb] = field_int(f[F_CC_TGT], 0);
+        nb++;
+    }
+    blk->n = nb;
+    return nb;
+}
+
+uint64_t trace_offset(const trace_reader_t *r) {
+    if (r->mapped) return (uint64_t)(r->cur - r->map);
+    return (uint64_t)(r->buf_off + (r->cur - r->buf));
+}
+
+uint64_t trace_header_hash(const trace_reader_t *r) {
+    return r->header_hash;
+}
+
+void trace_hold_partial(trace_reader_t *r) {
+    r->hold_partial = 1;
+}
+
+int trace_resume(trace_reader_t *r, uint64_t offset, long rows) {
+    if (r->bin || r->z) return -1;
+    if (r->mapped) {
+        if (offset > r->map_len) return -1;
+        r->cur = r->map + offset;
+    } else {
+        if (lseek(r->fd, (off_t)offset, SEEK_SET) != (off_t)offset) return -1;
+        r->cur = r->end = r->buf;
+        r->buf_off = (int64_t)offset;
+        r->eof = 0;
+    }
+    r->tgen = rows;
+    return 0;
+}
+
+int trace_failed(const trace_reader_t *r) {
+    return r->bin_corrupt || r->z_corrupt;
+}
+
+long trace_rows(const trace_reader_t *r) {
+    return r->tgen;
+}
+
+void trace_close(trace_reader_t *r) {
+    if (!r) return;
+    zin_close(r->z);
+#ifndef _WIN32
+    if (r->map) munmap(r->map, r->map_len);
+#endif
+    ecub_close(r->bin);
+    free(r->bin_cols);
+    for (int i = 0; i < 7; i++) free(r->bin_dflt[i]);
+    free(r->bin_time);
+    free(r->buf);
+    if (r->fd >= 0 && r->own_fd) close(r->fd);
+    free(r);
+}
+
+// ======================== Output sink ========================
+struct trace_sink {
+    writer_t      *csv;
+    ecub_writer_t *bin;
+
+    // trace_sink_write_run(): the run not yet written (RLE output), or
+    // the rows gathered into the next .ecub block.
+    int       rle;
+    int64_t   run_t;
+    int       run_state, run_speed;
+    long long run_n;
+    trace_block_t *pend;
+};
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+long trace_csv_stem(const char *path) {
+    static const char *const SUFFIX[] = { ".csv", ".csv.gz", ".csv.zst" };
+    for (size_t k = 0; k < sizeof(SUFFIX) / sizeof(SUFFIX[0]); k++) {
+        if (ends_with(path, SUFFIX[k])) return (long)(strlen(path) - strlen(SUFFIX[k]));
+    }
+    return -1;
+}
+
+char *trace_manifest_entry(char *line) {
+    char *p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    size_t n = strlen(p);
+    while (n && (p[n-1] == '\n' || p[n-1] == '\r' || p[n-1] == ' ' || p[n-1] == '\t')) p[--n] = '\0';
+    return n == 0 || p[0] == '#' ? NULL : p;
+}
+
+trace_sink_t *trace_sink_open(const char *path, writer_flush_t flush) {
+    trace_sink_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    if (ends_with(path, ".ecub")) {
+        s->bin = ecub_create(path, ECUB_OUTPUT_SCHEMA, 3);
+    } else {
+        s->csv = writer_open(path, flush);
+        if (s->csv) {
+            writer_str(s->csv, "time,engine_state,engine_speed");
+            writer_row_end(s->csv);
+        }
+    }
+    if (!s->csv && !s->bin) { free(s); return NULL; }
+    return s;
+}
+
+trace_sink_t *trace_sink_open_rle(const char *path, writer_flush_t flush) {
+    if (ends_with(path, ".ecub")) { errno = ENOTSUP; return NULL; }
+    trace_sink_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->csv = writer_open(path, flush);
+    if (!s->csv) { free(s); return NULL; }
+    s->rle = 1;
+    writer_str(s->csv, "time,engine_state,engine_speed,repeat");
+    writer_row_end(s->csv);
+    return s;
+}
+
+trace_sink_t *trace_sink_append(const char *path, writer_flush_t flush) {
+    if (ends_with(path, ".ecub")) { errno = ENOTSUP; return NULL; }
+    trace_sink_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->csv = writer_append(path, flush);
+    if (!s->csv) { free(s); return NULL; }
+    return s;
+}
+
+static void csv_row(writer_t *w, int64_t t, int engine_state, int engine_speed) {
+    writer_i64(w, t);
+    writer_char(w, ',');
+    writer_i64(w, engine_state);
+    writer_char(w, ',');
+    writer_i64(w, engine_speed);
+}
+
+static void flush_pending(trace_sink_t *s) {
+    if (s->rle && s->run_n > 0) {
+        csv_row(s->csv, s->run_t, s->run_state, s->run_speed);
+        writer_char(s->csv, ',');
+        writer_i64(s->csv, s->run_n);
+        writer_row_end(s->csv);
+        s->run_n = 0;
+    } else if (s->pend && s->pend->n > 0) {
+        const void *cols[3] = { s->pend->t, s->pend->engine_state, s->pend->engine_speed };
+        ecub_write_block(s->bin, s->pend->n, cols);
+        s->pend->n = 0;
+    }
+}
+
+void trace_sink_write_run(trace_sink_t *s, int64_t t, int engine_state, int engine_speed,
+                          long long count)
+{
+    if (count <= 0) return;
+    if (s->rle) {
+        if (s->run_n > 0 && t == s->run_t + s->run_n &&
+            engine_state == s->run_state && engine_speed == s->run_speed) {
+            s->run_n += count;
+            return;
+        }
+        flush_pending(s);
+        s->run_t = t;
+        s->run_state = engine_state;
+        s->run_speed = engine_speed;
+        s->run_n = count;
+        return;
+    }
+    if (s->bin) {
+        if (!s->pend && !(s->pend = calloc(1, sizeof(*s->pend)))) return;
+        for (long long k = 0; k < count; k++) {
+            trace_block_t *b = s->pend;
+            b->t[b->n] = t + k;
+            b->engine_state[b->n] = engine_state;
+            b->engine_speed[b->n] = engine_speed;
+            if (++b->n == TRACE_BLOCK_ROWS) flush_pending(s);
+        }
+        return;
+    }
+    for (long long k = 0; k < count; k++) {
+        csv_row(s->csv, t + k, engine_state, engine_speed);
+        writer_row_end(s->csv);
+    }
+}
+
+void trace_sink_write(trace_sink_t *s, size_t n, const int64_t *t,
+                      const int *engine_state, const int *engine_speed)
+{
+    if (s->rle) {
+        for (size_t i = 0; i < n; i++) trace_sink_write_run(s, t[i], engine_state[i], engine_speed[i], 1);
+        return;
+    }
+    if (s->bin) {
+        flush_pending(s);
+        const void *cols[3] = { t, engine_state, engine_speed };
+        ecub_write_block(s->bin, n, cols);
+        return;
+    }
+    writer_t *w = s->csv;
+    for (size_t i = 0; i < n; i++) {
+        csv_row(w, t[i], engine_state[i], engine_speed[i]);
+        writer_row_end(w);
+    }
+}
+
+void trace_sink_flush(trace_sink_t *s) {
+    if (s->csv) writer_flush(s->csv);
+}
+
+int trace_sink_close(trace_sink_t *s) {
+    if (!s) return 0;
+    flush_pending(s);
+    free(s->pend);
+    int rc = s->bin ? ecub_finish(s->bin) : writer_close(s->csv);
+    free(s);
+    return rc;
+}
@@ -0,0 +1,512 @@
+// app/c_files/tune.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "tune.h"
+#include "pool.h"
+#include "trace_io.h"
+
+#define TUNE_GRID       5       // points per axis per round (odd: the best point is re-tried)
+#define TUNE_ROUNDS     4
+#define TUNE_NAXES      4
+#define TUNE_BAND_RPM   10      // settling band: max(TUNE_BAND_RPM, 2% of target)
+
+typedef struct {
+    const char *key;
+    double lo, hi;              // search bounds
+    int    integer;
+} tune_axis_t;
+
+static const tune_axis_t AXES[TUNE_NAXES] = {
+    { "cc_kp",                  0.02, 1.0,   0 },
+    { "cc_max_step_per_iter",   1.0,  400.0, 1 },
+    { "idle_kp",                0.02, 1.0,   0 },
+    { "idle_max_step_per_iter", 1.0,  400.0, 1 },
+};
+
+typedef struct {
+    double overshoot, settle, revcut;
+} tune_weights_t;
+
+// One reference trace, 'repeat' rows expanded. Read-only once loaded.
+typedef struct {
+    char        *path;
+    ecu_input_t *rows;
+    size_t       n, cap;
+} ref_trace_t;
+
+typedef struct {
+    ref_trace_t *v;
+    size_t       count, cap;
+} trace_set_t;
+
+typedef struct {
+    double overshoot;           // rpm, peak per episode
+    long   settle;              // rows
+    long   revcut;              // rows
+    long   episodes;
+} tune_metrics_t;
+
+typedef struct {
+    const trace_set_t    *traces;
+    const tune_weights_t *w;
+    ecu_calib_t    cal;
+    double         x[TUNE_NAXES];
+    tune_metrics_t m;
+    double         cost;
+    int            rc;
+} candidate_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int has_suffix(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static inline int clamp_i(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// ======================== Weights ========================
+static int parse_weights(const char *spec, tune_weights_t *w) {
+    w->overshoot = w->settle = w->revcut = 1.0;
+    if (!spec) return 0;
+
+    const char *p = spec;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        char item[64];
+        if (len >= sizeof(item)) return -1;
+        memcpy(item, p, len);
+        item[len] = '\0';
+
+        char *eq = strchr(item, '=');
+        if (!eq) return -1;
+        *eq = '\0';
+        char *num_end;
+        double v = strtod(eq + 1, &num_end);
+        if (num_end == eq + 1 || *num_end != '\0' || v < 0.0) return -1;
+        if      (strcmp(item, "overshoot") == 0) w->overshoot = v;
+        else if (strcmp(item, "settle") == 0)    w->settle = v;
+        else if (strcmp(item, "revcut") == 0)    w->revcut = v;
+        else return -1;
+        p = end ? end + 1 : p + len;
+    }
+    return 0;
+}
+
+// ======================== Reference traces ========================
+static int trace_push(ref_trace_t *tr, const ecu_input_t *in) {
+    if (tr->n == tr->cap) {
+        size_t ncap = tr->cap ? tr->cap * 2 : TRACE_BLOCK_ROWS * 16;
+        ecu_input_t *nr = realloc(tr->rows, ncap * sizeof(*nr));
+        if (!nr) return -1;
+        tr->rows = nr; tr->cap = ncap;
+    }
+    tr->rows[tr->n++] = *in;
+    return 0;
+}
+
+static int load_trace(ref_trace_t *tr) {
+    trace_reader_t *r;
+    int rc = trace_open(tr->path, &r);
+    if (rc) return rc;
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) { trace_close(r); return 2; }
+    while (rc == 0 && trace_read_block(r, blk) > 0) {
+        for (size_t i = 0; i < blk->n && rc == 0; i++) {
+            ecu_input_t in = { blk->ign[i], blk->acc[i], blk->brk[i],
+                               blk->gear[i], blk->cc_en[i], blk->cc_tgt[i] };
+            for (int k = 0; k < blk->rep[i]; k++) {
+                if (trace_push(tr, &in) != 0) {
+                    fprintf(stderr, "%s: out of memory loading trace\n", tr->path);
+                    rc = 3;
+                    break;
+                }
+            }
+        }
+    }
+    if (rc == 0 && trace_failed(r)) rc = 3;
+    free(blk);
+    trace_close(r);
+    return rc;
+}
+
+static int add_trace(trace_set_t *set, const char *path) {
+    if (set->count == set->cap) {
+        size_t ncap = set->cap ? set->cap * 2 : 16;
+        ref_trace_t *nv = realloc(set->v, ncap * sizeof(*nv));
+        if (!nv) return -1;
+        set->v = nv; set->cap = ncap;
+    }
+    ref_trace_t *tr = &set->v[set->count];
+    memset(tr, 0, sizeof(*tr));
+    tr->path = strdup(path);
+    if (!tr->path) return -1;
+    set->count++;
+    return 0;
+}
+
+static int collect_dir(trace_set_t *set, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (trace_csv_stem(e->d_name) < 0 || strstr(e->d_name, "_out.csv")) continue;
+        size_t n = strlen(dir) + strlen(e->d_name) + 2;
+        char *path = malloc(n);
+        if (!path) break;
+        snprintf(path, n, "%s/%s", dir, e->d_name);
+        struct stat sb;
+        if (stat(path, &sb) == 0 && S_ISREG(sb.st_mode)) add_trace(set, path);
+        free(path);
+    }
+    closedir(d);
+    return 0;
+}
+
+static int collect_manifest(trace_set_t *set, const char *manifest) {
+    FILE *f = fopen(manifest, "r");
+    if (!f) return -1;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = trace_manifest_entry(line);
+        if (!p) continue;
+        add_trace(set, p);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int by_path(const void *a, const void *b) {
+    return strcmp(((const ref_trace_t *)a)->path, ((const ref_trace_t *)b)->path);
+}
+
+static void free_traces(trace_set_t *set) {
+    for (size_t i = 0; i < set->count; i++) {
+        free(set->v[i].path);
+        free(set->v[i].rows);
+    }
+    free(set->v);
+}
+
+// ======================== Cost ========================
+enum { EP_NONE, EP_CRUISE, EP_IDLE };
+
+typedef struct {
+    int  kind;
+    int  target;
+    int  dir;                   // +1 started below the target, -1 above
+    int  band;
+    int  peak;                  // furthest past the target, rpm
+    long len;
+    long last_out;              // last row outside the band, -1 if none
+} episode_t;
+
+static void episode_close(episode_t *ep, tune_metrics_t *m) {
+    if (ep->kind != EP_NONE && ep->len > 0) {
+        m->episodes++;
+        m->overshoot += ep->peak;
+        m->settle    += ep->last_out + 1;
+    }
+    ep->kind = EP_NONE;
+}
+
+// Which controller ecu_step() runs on this row, and its target; the same
+// conditions as SCR5 and SCR6/SCR7 in step_row().
+static int engaged(const ecu_calib_t *cal, const ecu_input_t *in, int *target) {
+    if (!in->ignition_switch) return EP_NONE;
+    const int acc   = clamp_i(in->acc_pedal_position,   0, 45);
+    const int brake = clamp_i(in->brake_pedal_position, 0, 45);
+    const int gear  = clamp_i(in->current_gear, 1, 5);
+    if (brake != 0) return EP_NONE;
+    int eff = acc;
+    if (brake >= cal->run.bto_brake && acc >= cal->run.bto_acc_min) {
+        double x = (double)acc * cal->run.bto_scale;
+        eff = clamp_i((int)(x + 0.5), 0, 45);
+    }
+    if (eff != 0) return EP_NONE;
+
+    if (in->cruise_enable == 1) {
+        if (gear < cal->cc_activation_gear_min) return EP_NONE;
+        *target = clamp_i(in->cruise_target_speed, cal->cc_target_min, cal->run.cc_target_hi);
+        return EP_CRUISE;
+    }
+    if (in->cruise_enable == 0 && gear <= cal->idle_activation_gear_max) {
+        *target = cal->idle_target_speed;
+        return EP_IDLE;
+    }
+    return EP_NONE;
+}
+
+static void trace_cost(const ecu_calib_t *cal, const ref_trace_t *tr, tune_metrics_t *m) {
+    ecu_state_t st;
+    ecu_state_init(&st);
+    episode_t ep = { EP_NONE, 0, 0, 0, 0, 0, -1 };
+
+    for (size_t i = 0; i < tr->n; i++) {
+        const ecu_input_t *in = &tr->rows[i];
+        const int prev = st.engine_speed;
+        int target = 0;
+        int kind = engaged(cal, in, &target);
+        const int speed = ecu_step(cal, &st, in);
+
+        if (kind != ep.kind || target != ep.target) {
+            episode_close(&ep, m);
+            if (kind != EP_NONE) {
+                ep.kind = kind;
+                ep.target = target;
+                ep.dir = prev <= target ? 1 : -1;
+                ep.band = target / 50 > TUNE_BAND_RPM ? target / 50 : TUNE_BAND_RPM;
+                ep.peak = 0;
+                ep.len = 0;
+                ep.last_out = -1;
+            }
+        }
+        if (ep.kind != EP_NONE) {
+            int err = speed - ep.target;
+            int past = ep.dir * err;
+            if (past > ep.peak) ep.peak = past;
+            if (err > ep.band || err < -ep.band) ep.last_out = ep.len;
+            ep.len++;
+        }
+        m->revcut += st.hard_cut_active;
+    }
+    episode_close(&ep, m);
+}
+
+static double cost_of(const tune_metrics_t *m, const tune_weights_t *w) {
+    return w->overshoot * m->overshoot + w->settle * (double)m->settle + w->revcut * (double)m->revcut;
+}
+
+static void run_candidate(void *arg, int worker) {
+    (void)worker;
+    candidate_t *c = arg;
+    memset(&c->m, 0, sizeof(c->m));
+    for (size_t i = 0; i < c->traces->count; i++) trace_cost(&c->cal, &c->traces->v[i], &c->m);
+    c->cost = cost_of(&c->m, c->w);
+}
+
+// ======================== Search ========================
+static double axis_value(int a, double x) {
+    if (x < AXES[a].lo) x = AXES[a].lo;
+    if (x > AXES[a].hi) x = AXES[a].hi;
+    return AXES[a].integer ? (double)(long)(x + 0.5) : x;
+}
+
+static int set_point(candidate_t *c, const ecu_calib_t *base, const double x[TUNE_NAXES]) {
+    c->cal = *base;
+    for (int a = 0; a < TUNE_NAXES; a++) {
+        char val[32];
+        c->x[a] = axis_value(a, x[a]);
+        snprintf(val, sizeof(val), "%.6g", c->x[a]);
+        c->x[a] = strtod(val, NULL);    // what the written file will hold
+        if (ecu_calib_set(&c->cal, AXES[a].key, val) != 0) return -1;
+    }
+    return 0;
+}
+
+static void print_point(FILE *f, const candidate_t *c) {
+    for (int a = 0; a < TUNE_NAXES; a++) fprintf(f, " %s=%.6g", AXES[a].key, c->x[a]);
+    fprintf(f, " cost=%.1f (overshoot=%.0f settle=%ld revcut=%ld episodes=%ld)",
+            c->cost, c->m.overshoot, c->m.settle, c->m.revcut, c->m.episodes);
+}
+
+// ======================== Output ========================
+// base_path's lines, with each tuned key's line replaced; keys the file
+// lacks are appended.
+// Written to out_path.tmp and renamed over out_path, so base_path may be
+// out_path itself (tuning a calibration in place).
+static int write_calib(const char *base_path, const char *out_path, const candidate_t *best) {
+    size_t n = strlen(out_path);
+    char *tmp = malloc(n + sizeof(".tmp"));
+    if (!tmp) return -1;
+    memcpy(tmp, out_path, n);
+    strcpy(tmp + n, ".tmp");
+
+    FILE *out = fopen(tmp, "w");
+    if (!out) { free(tmp); return -1; }
+    int done[TUNE_NAXES] = { 0 };
+
+    FILE *in = base_path ? fopen(base_path, "r") : NULL;
+    if (in) {
+        char line[4096];
+        while (fgets(line, sizeof(line), in)) {
+            const char *p = line;
+            while (*p == ' ' || *p == '\t') p++;
+            int hit = -1;
+            for (int a = 0; a < TUNE_NAXES && hit < 0; a++) {
+                size_t k = strlen(AXES[a].key);
+                const char *q = p + k;
+                while (*q == ' ' || *q == '\t') q++;
+                if (strncmp(p, AXES[a].key, k) == 0 && *q == '=') hit = a;
+            }
+            if (hit < 0 || done[hit]) {
+                fputs(line, out);
+                continue;
+            }
+            fprintf(out, "%s = %.6g\n", AXES[hit].key, best->x[hit]);
+            done[hit] = 1;
+        }
+        fclose(in);
+    }
+    int header = 0;
+    for (int a = 0; a < TUNE_NAXES; a++) {
+        if (done[a]) continue;
+        if (!header) { fprintf(out, "\n# --- Tuned (ecu_app --tune) ---\n"); header = 1; }
+        fprintf(out, "%s = %.6g\n", AXES[a].key, best->x[a]);
+    }
+    int ok = !ferror(out);
+    if (fclose(out) != 0) ok = 0;
+    if (ok && rename(tmp, out_path) != 0) ok = 0;
+    if (!ok) remove(tmp);
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+// ======================== Driver ========================
+int tune_run(const ecu_calib_t *base,
+             const char *base_path,
+             const char *source,
+             const char *out_path,
+             const char *weights,
+             int nthreads,
+             FILE *report)
+{
+    tune_weights_t w;
+    if (parse_weights(weights, &w) != 0) {
+        fprintf(stderr, "tune: bad weights '%s' (overshoot=W,settle=W,revcut=W)\n", weights);
+        return 2;
+    }
+
+    trace_set_t set = { NULL, 0, 0 };
+    struct stat sb;
+    if (stat(source, &sb) != 0) {
+        fprintf(stderr, "tune: %s: %s\n", source, strerror(errno));
+        return 2;
+    }
+    int rc;
+    if (S_ISDIR(sb.st_mode))                                       rc = collect_dir(&set, source);
+    else if (trace_csv_stem(source) >= 0 || has_suffix(source, ".ecub")) rc = add_trace(&set, source);
+    else                                                           rc = collect_manifest(&set, source);
+    if (rc != 0 || set.count == 0) {
+        fprintf(stderr, "tune: no reference traces in %s\n", source);
+        free_traces(&set);
+        return 2;
+    }
+    qsort(set.v, set.count, sizeof(set.v[0]), by_path);
+
+    // --- One parsed copy of every trace, shared by all candidates ---
+    long total_rows = 0;
+    for (size_t i = 0; i < set.count; i++) {
+        rc = load_trace(&set.v[i]);
+        if (rc) { free_traces(&set); return rc; }
+        total_rows += (long)set.v[i].n;
+    }
+
+    pool_t *pool = pool_create(nthreads);
+    enum { NCAND = TUNE_GRID * TUNE_GRID * TUNE_GRID * TUNE_GRID };
+    candidate_t *cand = malloc(NCAND * sizeof(*cand));
+    if (!pool || !cand) {
+        fprintf(stderr, "tune: cannot start worker threads\n");
+        if (pool) pool_destroy(pool);
+        free(cand);
+        free_traces(&set);
+        return 2;
+    }
+
+    // Base calibration first: the score to beat.
+    candidate_t best;
+    double x0[TUNE_NAXES] = { base->cc_kp, base->cc_max_step_per_iter,
+                              base->idle_kp, base->idle_max_step_per_iter };
+    best.traces = &set;
+    best.w = &w;
+    best.cal = *base;       // as loaded: out-of-range values are not clamped
+    memcpy(best.x, x0, sizeof(best.x));
+    run_candidate(&best, 0);
+    const double base_cost = best.cost;
+    if (report) {
+        fprintf(report, "tune: traces=%zu rows=%ld threads=%d\ntune: base", set.count, total_rows, pool_size(pool));
+        print_point(report, &best);
+        fputc('\n', report);
+    }
+
+    double lo[TUNE_NAXES], hi[TUNE_NAXES];
+    for (int a = 0; a < TUNE_NAXES; a++) { lo[a] = AXES[a].lo; hi[a] = AXES[a].hi; }
+
+    double t0 = now_seconds();
+    long evaluated = 0;
+    int improved = 0;
+    rc = 0;
+    for (int round = 0; round < TUNE_ROUNDS && rc == 0; round++) {
+        int n = 0;
+        for (int k = 0; k < NCAND; k++) {
+            double x[TUNE_NAXES];
+            int rem = k;
+            for (int a = TUNE_NAXES - 1; a >= 0; a--) {
+                int idx = rem % TUNE_GRID;
+                rem /= TUNE_GRID;
+                x[a] = lo[a] + (hi[a] - lo[a]) * idx / (TUNE_GRID - 1);
+            }
+            candidate_t *c = &cand[n];
+            c->traces = &set;
+            c->w = &w;
+            if (set_point(c, base, x) != 0) {
+                fprintf(stderr, "tune: cannot set candidate calibration\n");
+                rc = 2;
+                break;
+            }
+            n++;
+        }
+        if (rc) break;
+        for (int k = 0; k < n; k++) pool_submit(pool, run_candidate, &cand[k]);
+        pool_wait(pool);
+        evaluated += n;
+
+        // Lowest cost wins; ties keep the earlier grid point, so the
+        // result does not depend on the thread count.
+        for (int k = 0; k < n; k++) {
+            if (cand[k].cost < best.cost) { best = cand[k]; improved = 1; }
+        }
+        if (report) {
+            fprintf(report, "tune: round %d", round + 1);
+            print_point(report, &best);
+            fputc('\n', report);
+        }
+
+        // Next round: one grid step either side of the best point.
+        for (int a = 0; a < TUNE_NAXES; a++) {
+            double half = (hi[a] - lo[a]) / (TUNE_GRID - 1);
+            lo[a] = best.x[a] - half;
+            hi[a] = best.x[a] + half;
+            if (lo[a] < AXES[a].lo) { hi[a] += AXES[a].lo - lo[a]; lo[a] = AXES[a].lo; }
+            if (hi[a] > AXES[a].hi) { lo[a] -= hi[a] - AXES[a].hi; hi[a] = AXES[a].hi; }
+            if (lo[a] < AXES[a].lo) lo[a] = AXES[a].lo;
+        }
+    }
+    double wall = now_seconds() - t0;
+    pool_destroy(pool);
+    free(cand);
+
+    // Nothing beat the base: leave out_path alone.
+    if (rc == 0 && improved && write_calib(base_path, out_path, &best) != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        rc = 4;
+    }
+    if (rc == 0 && report) {
+        fprintf(report, "tune: candidates=%ld wall_s=%.3f rows_per_s=%.0f cost %.1f -> %.1f, %s %s\n",
+                evaluated, wall, wall > 0.0 ? (double)evaluated * (double)total_rows / wall : 0.0,
+                base_cost, best.cost, improved ? "wrote" : "base not beaten, did not write", out_path);
+    }
+    free_traces(&set);
+    return rc;
+}
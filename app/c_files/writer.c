@@ -0,0 +1,207 @@
+// app/c_files/writer.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "writer.h"
+#include "zio.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define DIRECT_ALIGN 4096
+
+struct writer {
+    int    fd;
+    int    policy;
+    int    direct;          // fd really has O_DIRECT set
+    int    failed;
+    int    own_fd;          // 0 when writing stdout ("-")
+    zout_t *z;              // .gz / .zst output, compressed on flush
+    size_t len;
+    char  *buf;             // WRITER_BUF_BYTES, DIRECT_ALIGN-aligned
+};
+
+// "00010203...99": two output digits per table lookup
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void write_all(writer_t *w, const char *p, size_t n) {
+    while (n > 0 && !w->failed) {
+        ssize_t got = write(w->fd, p, n);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            w->failed = 1;
+            return;
+        }
+        p += got;
+        n -= (size_t)got;
+    }
+}
+
+static void flush_buf(writer_t *w) {
+    if (w->len == 0) return;
+    if (w->z) {
+        if (zout_write(w->z, w->buf, w->len, w->policy == WRITER_FLUSH_ROW) != 0) w->failed = 1;
+        w->len = 0;
+        return;
+    }
+    size_t n = w->len;
+    if (w->direct) {
+        // O_DIRECT wants aligned lengths: write whole pages, keep the tail.
+        n -= n % DIRECT_ALIGN;
+        if (n == 0) return;
+    }
+    write_all(w, w->buf, n);
+    memmove(w->buf, w->buf + n, w->len - n);
+    w->len -= n;
+}
+
+static writer_t *open_with(const char *path, writer_flush_t policy, int oflags) {
+    writer_t *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->policy = policy;
+    w->buf = aligned_alloc(DIRECT_ALIGN, WRITER_BUF_BYTES);
+    if (!w->buf) { free(w); return NULL; }
+
+    w->fd = -1;
+    w->own_fd = strcmp(path, "-") != 0;
+    if (!w->own_fd) {
+        w->fd = STDOUT_FILENO;
+        return w;
+    }
+    zio_format_t zf = zio_from_path(path);
+    if (!zio_supported(zf)) {
+        free(w->buf);
+        free(w);
+        errno = ENOTSUP;
+        return NULL;
+    }
+    // Compressed output is written in whatever sizes the compressor emits.
+    if (zf != ZIO_NONE && policy == WRITER_FLUSH_DIRECT) w->policy = policy = WRITER_FLUSH_BATCH;
+#if defined(O_DIRECT)
+    if (policy == WRITER_FLUSH_DIRECT) {
+        w->fd = open(path, oflags | O_DIRECT, 0666);
+        w->direct = (w->fd >= 0);
+    }
+#endif
+    if (w->fd < 0) w->fd = open(path, oflags, 0666);
+    if (w->fd < 0) {
+        int e = errno;
+        free(w->buf);
+        free(w);
+        errno = e;
+        return NULL;
+    }
+    if (zf != ZIO_NONE && !(w->z = zout_open(zf, w->fd))) {
+        int e = errno;
+        close(w->fd);
+        free(w->buf);
+        free(w);
+        errno = e;
+        return NULL;
+    }
+    return w;
+}
+
+writer_t *writer_open(const char *path, writer_flush_t policy) {
+    return open_with(path, policy, O_WRONLY | O_CREAT | O_TRUNC);
+}
+
+writer_t *writer_append(const char *path, writer_flush_t policy) {
+    // O_DIRECT needs aligned file offsets, which an append cannot promise.
+    if (policy == WRITER_FLUSH_DIRECT) policy = WRITER_FLUSH_BATCH;
+    return open_with(path, policy, O_WRONLY | O_APPEND);
+}
+
+int writer_parse_policy(const char *name) {
+    if (strcmp(name, "batch") == 0)  return WRITER_FLUSH_BATCH;
+    if (strcmp(name, "row") == 0)    return WRITER_FLUSH_ROW;
+    if (strcmp(name, "direct") == 0) return WRITER_FLUSH_DIRECT;
+    return -1;
+}
+
+void writer_bytes(writer_t *w, const char *s, size_t n) {
+    while (n > 0) {
+        if (w->len == WRITER_BUF_BYTES) flush_buf(w);
+        if (w->failed) return;
+        size_t room = WRITER_BUF_BYTES - w->len;
+        size_t k = n < room ? n : room;
+        memcpy(w->buf + w->len, s, k);
+        w->len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+void writer_str(writer_t *w, const char *s) {
+    writer_bytes(w, s, strlen(s));
+}
+
+void writer_char(writer_t *w, char c) {
+    if (w->len == WRITER_BUF_BYTES) flush_buf(w);
+    if (w->len < WRITER_BUF_BYTES) w->buf[w->len++] = c;
+}
+
+void writer_i64(writer_t *w, int64_t v) {
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    // Work on the magnitude as unsigned so INT64_MIN is fine.
+    uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    while (u >= 100) {
+        unsigned d = (unsigned)(u % 100) * 2;
+        u /= 100;
+        *--p = DIGIT_PAIRS[d + 1];
+        *--p = DIGIT_PAIRS[d];
+    }
+    if (u >= 10) {
+        unsigned d = (unsigned)u * 2;
+        *--p = DIGIT_PAIRS[d + 1];
+        *--p = DIGIT_PAIRS[d];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    if (v < 0) *--p = '-';
+    size_t n = (size_t)(tmp + sizeof(tmp) - p);
+    if (WRITER_BUF_BYTES - w->len >= n) {
+        memcpy(w->buf + w->len, p, n);
+        w->len += n;
+    } else {
+        writer_bytes(w, p, n);
+    }
+}
+
+void writer_flush(writer_t *w) {
+    flush_buf(w);
+}
+
+void writer_row_end(writer_t *w) {
+    writer_char(w, '\n');
+    if (w->policy == WRITER_FLUSH_ROW) flush_buf(w);
+}
+
+int writer_close(writer_t *w) {
+    if (!w) return 0;
+    flush_buf(w);
+#if defined(O_DIRECT) && !defined(_WIN32)
+    if (w->direct && w->len) {
+        // Unaligned tail: drop O_DIRECT for the last partial page.
+        int fl = fcntl(w->fd, F_GETFL);
+        if (fl == -1 || fcntl(w->fd, F_SETFL, fl & ~O_DIRECT) == -1) w->failed = 1;
+        w->direct = 0;
+        flush_buf(w);
+    }
+#endif
+    if (w->z && zout_close(w->z) != 0) w->failed = 1;
+    if (w->own_fd && close(w->fd) != 0) w->failed = 1;
+    int rc = w->failed ? -1 : 0;
+    free(w->buf);
+    free(w);
+    return rc;
+}
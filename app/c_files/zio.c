@@ -0,0 +1,419 @@
+// app/c_files/zio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef ECU_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ECU_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include "zio.h"
+
+#define ZIN_CHUNK     (1 << 18)     // decompressed bytes per queue slot
+#define ZIN_SLOTS     8             // queue depth: 2 MiB ahead of the reader
+#define ZIN_IN_BYTES  (1 << 16)     // compressed read() size
+#define ZIN_MAX_FEED  (1u << 30)    // mapping fed in pieces (zlib counts in uInt)
+#define ZOUT_BYTES    (1 << 16)
+
+#if defined(ECU_WITH_ZLIB) || defined(ECU_WITH_ZSTD)
+#define ZIO_ANY 1
+#else
+#define ZIO_ANY 0
+#endif
+
+zio_format_t zio_detect(const void *p, size_t n) {
+    const unsigned char *b = p;
+    if (n >= 2 && b[0] == 0x1f && b[1] == 0x8b) return ZIO_GZIP;
+    if (n >= 4 && b[0] == 0x28 && b[1] == 0xb5 && b[2] == 0x2f && b[3] == 0xfd) return ZIO_ZSTD;
+    return ZIO_NONE;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+zio_format_t zio_from_path(const char *path) {
+    if (ends_with(path, ".gz"))  return ZIO_GZIP;
+    if (ends_with(path, ".zst")) return ZIO_ZSTD;
+    return ZIO_NONE;
+}
+
+const char *zio_name(zio_format_t f) {
+    switch (f) {
+    case ZIO_GZIP: return "gzip";
+    case ZIO_ZSTD: return "zstd";
+    default:       return "none";
+    }
+}
+
+int zio_supported(zio_format_t f) {
+    switch (f) {
+#ifdef ECU_WITH_ZLIB
+    case ZIO_GZIP: return 1;
+#endif
+#ifdef ECU_WITH_ZSTD
+    case ZIO_ZSTD: return 1;
+#endif
+    case ZIO_NONE: return 1;
+    default:       return 0;
+    }
+}
+
+#if ZIO_ANY
+static int write_all(int fd, const void *p, size_t n) {
+    const char *c = p;
+    while (n > 0) {
+        ssize_t got = write(fd, c, n);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        c += got;
+        n -= (size_t)got;
+    }
+    return 0;
+}
+#endif
+
+// ======================== Input ========================
+typedef struct {
+    char  *buf;
+    size_t len;
+} chunk_t;
+
+struct zin {
+    zio_format_t fmt;
+    const unsigned char *data;  // not yet fed: the prefix or the mapping
+    size_t data_len;
+    void  *data_copy;
+    int    fd;
+    unsigned char *inbuf;
+
+    pthread_t       thread;
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    chunk_t slot[ZIN_SLOTS];    // ring of filled chunks, oldest at head
+    unsigned head, count;
+    int done, failed, stop;
+
+    size_t off;                 // reader: bytes of slot[head] handed out
+};
+
+#if ZIO_ANY
+// Next piece of compressed input: the prefix first, then fd. 0 at the end.
+static size_t next_input(zin_t *z, const unsigned char **p) {
+    if (z->data_len) {
+        size_t n = z->data_len < ZIN_MAX_FEED ? z->data_len : ZIN_MAX_FEED;
+        *p = z->data;
+        z->data += n;
+        z->data_len -= n;
+        return n;
+    }
+    if (z->fd < 0) return 0;
+    ssize_t got;
+    do {
+        got = read(z->fd, z->inbuf, ZIN_IN_BYTES);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) return 0;
+    *p = z->inbuf;
+    return (size_t)got;
+}
+
+// Thread: the slot after the filled ones, waiting while the queue is
+// full. NULL once the reader has closed.
+static chunk_t *claim(zin_t *z) {
+    pthread_mutex_lock(&z->mu);
+    while (z->count == ZIN_SLOTS && !z->stop) pthread_cond_wait(&z->cv, &z->mu);
+    chunk_t *c = z->stop ? NULL : &z->slot[(z->head + z->count) % ZIN_SLOTS];
+    pthread_mutex_unlock(&z->mu);
+    if (c) c->len = 0;
+    return c;
+}
+
+static void publish(zin_t *z) {
+    pthread_mutex_lock(&z->mu);
+    z->count++;
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+}
+#endif
+
+#ifdef ECU_WITH_ZLIB
+// Concatenated gzip members (e.g. appended output) decode as one stream.
+static int run_gzip(zin_t *z) {
+    z_stream s;
+    memset(&s, 0, sizeof(s));
+    if (inflateInit2(&s, 15 + 16) != Z_OK) return -1;
+
+    int rc = 0, ended = 0, full = 0;
+    chunk_t *c = NULL;
+    for (;;) {
+        if (s.avail_in == 0 && !full) {
+            // About to block on input: hand over what is decoded so far.
+            if (c && c->len) { publish(z); c = NULL; }
+            const unsigned char *p;
+            size_t n = next_input(z, &p);
+            if (n == 0) { if (!ended) rc = -1; break; }
+            s.next_in = (Bytef *)p;
+            s.avail_in = (uInt)n;
+        }
+        if (ended && s.avail_in > 0) {          // another member follows
+            if (inflateReset(&s) != Z_OK) { rc = -1; break; }
+            ended = 0;
+        }
+        if (!c && !(c = claim(z))) break;
+        s.next_out = (Bytef *)c->buf + c->len;
+        s.avail_out = (uInt)(ZIN_CHUNK - c->len);
+        int zr = inflate(&s, Z_NO_FLUSH);
+        c->len = ZIN_CHUNK - s.avail_out;
+        full = (s.avail_out == 0);
+        if (zr == Z_STREAM_END) ended = 1;
+        else if (zr != Z_OK && zr != Z_BUF_ERROR) { rc = -1; break; }
+        if (full) { publish(z); c = NULL; }
+    }
+    if (c && c->len) publish(z);
+    inflateEnd(&s);
+    return rc;
+}
+#endif
+
+#ifdef ECU_WITH_ZSTD
+static int run_zstd(zin_t *z) {
+    ZSTD_DCtx *d = ZSTD_createDCtx();
+    if (!d) return -1;
+
+    int rc = 0, started = 0, full = 0;
+    size_t left = 0;                    // 0: at a frame boundary
+    ZSTD_inBuffer in = { NULL, 0, 0 };
+    chunk_t *c = NULL;
+    for (;;) {
+        if (in.pos == in.size && !full) {
+            if (c && c->len) { publish(z); c = NULL; }
+            const unsigned char *p;
+            size_t n = next_input(z, &p);
+            if (n == 0) { if (left != 0 || !started) rc = -1; break; }
+            in.src = p;
+            in.size = n;
+            in.pos = 0;
+            started = 1;
+        }
+        if (!c && !(c = claim(z))) break;
+        ZSTD_outBuffer out = { c->buf, ZIN_CHUNK, c->len };
+        left = ZSTD_decompressStream(d, &out, &in);
+        if (ZSTD_isError(left)) { rc = -1; break; }
+        c->len = out.pos;
+        full = (out.pos == out.size);
+        if (full) { publish(z); c = NULL; }
+    }
+    if (c && c->len) publish(z);
+    ZSTD_freeDCtx(d);
+    return rc;
+}
+#endif
+
+static void *zin_main(void *arg) {
+    zin_t *z = arg;
+    int rc = -1;
+#ifdef ECU_WITH_ZLIB
+    if (z->fmt == ZIO_GZIP) rc = run_gzip(z);
+#endif
+#ifdef ECU_WITH_ZSTD
+    if (z->fmt == ZIO_ZSTD) rc = run_zstd(z);
+#endif
+    pthread_mutex_lock(&z->mu);
+    z->done = 1;
+    z->failed = (rc != 0);
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+    return NULL;
+}
+
+static void zin_free(zin_t *z) {
+    for (int i = 0; i < ZIN_SLOTS; i++) free(z->slot[i].buf);
+    free(z->inbuf);
+    free(z->data_copy);
+    free(z);
+}
+
+zin_t *zin_open(zio_format_t f, const void *data, size_t n, int fd) {
+    if (f == ZIO_NONE || !zio_supported(f)) { errno = ENOTSUP; return NULL; }
+    zin_t *z = calloc(1, sizeof(*z));
+    if (!z) return NULL;
+    z->fmt = f;
+    z->fd = fd;
+    if (fd >= 0 && n) {
+        if (!(z->data_copy = malloc(n))) { zin_free(z); return NULL; }
+        memcpy(z->data_copy, data, n);
+        data = z->data_copy;
+    }
+    z->data = data;
+    z->data_len = n;
+    if (fd >= 0 && !(z->inbuf = malloc(ZIN_IN_BYTES))) { zin_free(z); return NULL; }
+    for (int i = 0; i < ZIN_SLOTS; i++) {
+        if (!(z->slot[i].buf = malloc(ZIN_CHUNK))) { zin_free(z); return NULL; }
+    }
+
+    pthread_mutex_init(&z->mu, NULL);
+    pthread_cond_init(&z->cv, NULL);
+    if (pthread_create(&z->thread, NULL, zin_main, z) != 0) {
+        pthread_cond_destroy(&z->cv);
+        pthread_mutex_destroy(&z->mu);
+        zin_free(z);
+        return NULL;
+    }
+    return z;
+}
+
+long zin_read(zin_t *z, void *dst, size_t cap) {
+    pthread_mutex_lock(&z->mu);
+    while (z->count == 0 && !z->done) pthread_cond_wait(&z->cv, &z->mu);
+    if (z->count == 0) {
+        int failed = z->failed;
+        pthread_mutex_unlock(&z->mu);
+        return failed ? -1 : 0;
+    }
+    pthread_mutex_unlock(&z->mu);
+
+    // slot[head] is the reader's until it is released below.
+    chunk_t *c = &z->slot[z->head];
+    size_t n = c->len - z->off;
+    if (n > cap) n = cap;
+    memcpy(dst, c->buf + z->off, n);
+    z->off += n;
+    if (z->off == c->len) {
+        z->off = 0;
+        pthread_mutex_lock(&z->mu);
+        z->head = (z->head + 1) % ZIN_SLOTS;
+        z->count--;
+        pthread_cond_broadcast(&z->cv);
+        pthread_mutex_unlock(&z->mu);
+    }
+    return (long)n;
+}
+
+void zin_close(zin_t *z) {
+    if (!z) return;
+    pthread_mutex_lock(&z->mu);
+    z->stop = 1;
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+    pthread_join(z->thread, NULL);
+    pthread_cond_destroy(&z->cv);
+    pthread_mutex_destroy(&z->mu);
+    zin_free(z);
+}
+
+// ======================== Output ========================
+struct zout {
+    zio_format_t fmt;
+    int fd;
+    int failed;
+    unsigned char *buf;
+#ifdef ECU_WITH_ZLIB
+    z_stream s;
+#endif
+#ifdef ECU_WITH_ZSTD
+    ZSTD_CCtx *cctx;
+#endif
+};
+
+zout_t *zout_open(zio_format_t f, int fd) {
+    if (f == ZIO_NONE || !zio_supported(f)) { errno = ENOTSUP; return NULL; }
+    zout_t *z = calloc(1, sizeof(*z));
+    if (!z) return NULL;
+    z->fmt = f;
+    z->fd = fd;
+    z->buf = malloc(ZOUT_BYTES);
+    int ok = z->buf != NULL;
+#ifdef ECU_WITH_ZLIB
+    // Level 1: output is mostly repeated digits and compresses well anyway.
+    if (ok && f == ZIO_GZIP) ok = deflateInit2(&z->s, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#endif
+#ifdef ECU_WITH_ZSTD
+    if (ok && f == ZIO_ZSTD) {
+        z->cctx = ZSTD_createCCtx();
+        ok = z->cctx && !ZSTD_isError(ZSTD_CCtx_setParameter(z->cctx, ZSTD_c_compressionLevel, 3));
+    }
+#endif
+    if (!ok) {
+#ifdef ECU_WITH_ZSTD
+        ZSTD_freeCCtx(z->cctx);
+#endif
+        free(z->buf);
+        free(z);
+        return NULL;
+    }
+    return z;
+}
+
+// mode: 0 continue, 1 flush, 2 end of stream
+static int zout_pump(zout_t *z, const void *p, size_t n, int mode) {
+#ifdef ECU_WITH_ZLIB
+    if (z->fmt == ZIO_GZIP) {
+        const int how = mode == 2 ? Z_FINISH : (mode == 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+        z->s.next_in = (Bytef *)p;
+        z->s.avail_in = (uInt)n;
+        int zr;
+        do {
+            z->s.next_out = z->buf;
+            z->s.avail_out = ZOUT_BYTES;
+            zr = deflate(&z->s, how);
+            if (zr == Z_STREAM_ERROR) return -1;
+            if (write_all(z->fd, z->buf, ZOUT_BYTES - z->s.avail_out) != 0) return -1;
+        } while (z->s.avail_out == 0 || (mode == 2 && zr != Z_STREAM_END));
+        return 0;
+    }
+#endif
+#ifdef ECU_WITH_ZSTD
+    if (z->fmt == ZIO_ZSTD) {
+        const ZSTD_EndDirective how = mode == 2 ? ZSTD_e_end : (mode == 1 ? ZSTD_e_flush : ZSTD_e_continue);
+        ZSTD_inBuffer in = { p, n, 0 };
+        size_t left;
+        do {
+            ZSTD_outBuffer out = { z->buf, ZOUT_BYTES, 0 };
+            left = ZSTD_compressStream2(z->cctx, &out, &in, how);
+            if (ZSTD_isError(left)) return -1;
+            if (write_all(z->fd, z->buf, out.pos) != 0) return -1;
+        } while (how == ZSTD_e_continue ? in.pos < in.size : left != 0);
+        return 0;
+    }
+#endif
+    (void)z; (void)p; (void)n; (void)mode;
+    return -1;
+}
+
+int zout_write(zout_t *z, const void *p, size_t n, int flush) {
+    if (z->failed) return -1;
+    // zlib counts in uInt: large buffers go in pieces.
+    while (n > ZIN_MAX_FEED) {
+        if (zout_pump(z, p, ZIN_MAX_FEED, 0) != 0) { z->failed = 1; return -1; }
+        p = (const char *)p + ZIN_MAX_FEED;
+        n -= ZIN_MAX_FEED;
+    }
+    if (zout_pump(z, p, n, flush ? 1 : 0) != 0) z->failed = 1;
+    return z->failed ? -1 : 0;
+}
+
+int zout_close(zout_t *z) {
+    if (!z) return 0;
+    if (!z->failed && zout_pump(z, NULL, 0, 2) != 0) z->failed = 1;
+#ifdef ECU_WITH_ZLIB
+    if (z->fmt == ZIO_GZIP) deflateEnd(&z->s);
+#endif
+#ifdef ECU_WITH_ZSTD
+    ZSTD_freeCCtx(z->cctx);
+#endif
+    int rc = z->failed ? -1 : 0;
+    free(z->buf);
+    free(z);
+    return rc;
+}
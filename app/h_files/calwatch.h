@@ -0,0 +1,35 @@
+#ifndef CALWATCH_H
+#define CALWATCH_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Calibration hot reload ----------
+// A background thread watches the calibration file (inotify on its
+// directory, so editors that save by rename are seen too), re-parses it
+// and publishes the result; the row thread picks it up between rows with
+// one atomic exchange and never waits on file I/O. The row thread owns
+// the calibration it runs with and frees the one it replaces, so a
+// calibration is never freed while rows still use it.
+typedef struct calwatch calwatch_t;
+
+/**
+ * Starts watching path; initial is copied and served until the first
+ * reload. Rejected reloads (file missing or empty, unknown or duplicate
+ * keys, a value that does not parse or its key refuses) and
+ * unchanged ones are described on log and leave the current calibration
+ * in place. NULL (with a message on log) if watching is not possible.
+ */
+calwatch_t *calwatch_start(const char *path, const ecu_calib_t *initial, FILE *log);
+/**
+ * Row thread only: the calibration for the next row, which is row (0
+ * based). Swaps in a newly published calibration and logs the row it
+ * took effect at. The pointer stays valid until the next call.
+ */
+const ecu_calib_t *calwatch_current(calwatch_t *w, long row);
+/** Number of reloads that took effect. */
+int calwatch_swaps(const calwatch_t *w);
+/** Stops the watcher thread and frees everything. */
+void calwatch_stop(calwatch_t *w);
+
+#endif
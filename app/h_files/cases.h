@@ -0,0 +1,24 @@
+#ifndef CASES_H
+#define CASES_H
+
+#include <stddef.h>
+
+// ---------- Testcase discovery ----------
+// testcases/SCR<nnnnnn>/case<m>/{case<m>.csv,golden.csv}; the calibration
+// is calibration/calib_scr<n>_case<m>.txt or calib_scr<n>_case<m>_<note>.txt
+// when one exists, calibration/calibration.txt otherwise.
+typedef struct {
+    char name[64];          // "SCR000010/case4"
+    int  scr;
+    char input[1024];
+    char golden[1024];
+    char calib[1024];
+} ecu_case_t;
+
+/**
+ * Lists every case under cases_dir in path order. Returns the count
+ * (*out is malloc'd, free it), or -1 if nothing matched.
+ */
+int cases_find(const char *cases_dir, const char *calib_dir, ecu_case_t **out);
+
+#endif
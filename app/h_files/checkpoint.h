@@ -0,0 +1,27 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "ecu.h"
+
+// ---------- Checkpoint (resume an appended trace) ----------
+#define CKPT_MAGIC   "ECKP"
+#define CKPT_VERSION 2
+#define CKPT_OUT_UNKNOWN UINT64_MAX    // out_bytes when the output is not a regular file
+
+/** Everything needed to continue a trace where the last run stopped. */
+typedef struct {
+    ecu_state_t state;
+    int64_t  rows;          // data rows consumed (also the next generated time)
+    uint64_t offset;        // input bytes consumed
+    uint64_t out_bytes;     // output length once those rows were written
+    uint64_t calib_hash;    // ecu_calib_hash() of the run
+    uint64_t header_hash;   // trace_header_hash() of the input
+} ecu_checkpoint_t;
+
+/** Returns 0, 1 if path does not exist, or -1 (message on stderr) if unusable. */
+int ckpt_load(const char *path, ecu_checkpoint_t *ck);
+/** Writes path atomically (temp file + rename); 0 or -1. */
+int ckpt_save(const char *path, const ecu_checkpoint_t *ck);
+
+#endif
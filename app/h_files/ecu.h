@@ -1,6 +1,149 @@
 #ifndef ECU_H
 #define ECU_H
 
+#include <stdio.h>
+#include <stddef.h>
+
+// ---------- Fixed-point format ----------
+// Number of fraction bits used by ecu_step_q(). Building with
+// -DECU_FIXED_POINT makes ecu_step()/ecu_run_batch() use that path.
+#ifndef ECU_Q_BITS
+#define ECU_Q_BITS 16
+#endif
+#if ECU_Q_BITS < 8 || ECU_Q_BITS > 30
+#error "ECU_Q_BITS must be within [8, 30]"
+#endif
+
+// ---------- Calibration (SCR2..SCR12) ----------
+/**
+ * Parsed calibration.txt. ecu_calib_load() fills every field with its SCR
+ * default and then overrides whatever keys the file provides, applying the
+ * same per-key sanitising the parse_* functions have always applied.
+ */
+typedef struct {
+    // SCR2..SCR4
+    int    max_engine_speed;
+    int    brake_gain_rpm_per_deg;
+    double gear_mult[6];            // [0] unused, [1..5] per gear
+
+    // SCR5
+    double cc_kp;
+    int    cc_max_step_per_iter;
+    int    cc_activation_gear_min;
+    int    cc_target_min;
+    int    cc_target_max;
+
+    // SCR6
+    int    drag_rpm_per_iter;
+
+    // SCR7
+    int    idle_target_speed;
+    double idle_kp;
+    int    idle_max_step_per_iter;
+    int    idle_activation_gear_max;
+
+    // SCR8
+    int    slew_max_rise_per_iter;
+    int    slew_max_fall_per_iter;
+
+    // SCR9
+    int    acc_overlap_deg;
+    int    brk_overlap_deg;
+    int    limp_rows_confirm;
+    int    limp_max_speed;
+    double limp_acc_gain_scale;
+    int    limp_clear_on_ignition_off;
+
+    // SCR10
+    int    rev_soft_limit;
+    int    rev_hard_limit;
+    int    rev_hysteresis;
+    int    rev_hard_cut_step;
+    int    rev_cut_cooldown_rows;
+
+    // SCR11
+    int    bto_brake_deg;
+    int    bto_acc_min_deg;
+    double bto_acc_scale;
+
+    // SCR12
+    int    bto_release_ramp_rows;
+    int    bto_release_reset_on_ign_off;
+
+    // Loader bookkeeping
+    unsigned long long present;     // one bit per key-table entry found in the file
+    int    key_lines[64];           // lines applied per key-table entry (the parse_* counts)
+    int    unknown_keys;
+    int    duplicate_keys;
+    int    rejected_values;         // lines whose value did not parse or the key's rule refused
+
+    // Derived by ecu_calib_prepare(): the runtime sanitising each SCR
+    // function used to redo per row, done once. Read by ecu_step().
+    struct {
+        double acc_gain[6];         // ACC_BASE_GAIN_RPM_PER_DEG * gear_mult[g]
+        int    cc_target_hi;        // min(cc_target_max, max_engine_speed)
+        int    drag;                // drag_rpm_per_iter, >= 0
+        int    slew_rise;           // >= 0
+        int    slew_fall;           // >= 0
+        int    acc_overlap;         // >= 0
+        int    brk_overlap;         // >= 0
+        int    limp_need;           // limp_rows_confirm, >= 1
+        int    limp_cap;            // limp_max_speed within [0, max_engine_speed]
+        int    rev_soft;            // bounded to max and kept below rev_hard
+        int    rev_hard;
+        int    rev_hysteresis;
+        int    rev_cut_step;
+        int    rev_cooldown;
+        int    bto_brake;           // >= 0
+        int    bto_acc_min;         // >= 0
+        double bto_scale;           // within [0, 1]
+
+        // Fixed-point copies (Q ECU_Q_BITS) for ecu_step_q()
+        long long acc_gain_q[6];
+        long long cc_kp_q;
+        long long idle_kp_q;
+
+        // Per-pedal tables, indexed by the clamped inputs
+        int           acc_lut[6][46];   // round(acc_gain[g] * eff); INT_MIN: near .5, use double
+        int           brake_lut[46];    // brake * brake_gain_rpm_per_deg
+        unsigned char bto_eff[46][46];  // [brake][acc] -> SCR11 effective acc (ecu_step_q() too)
+    } run;
+} ecu_calib_t;
+
+/** Fills every calibration with its SCR default and clears the bookkeeping. */
+void ecu_calib_defaults(ecu_calib_t *cal);
+/**
+ * Reads calib_path once and applies each `key = value` line. Unknown,
+ * duplicate and malformed lines are counted and, if report is non-NULL,
+ * described there. Returns the number of keys applied, or -1 if the file
+ * cannot be opened (cal then holds the defaults).
+ */
+int ecu_calib_load(const char *calib_path, ecu_calib_t *cal, FILE *report);
+/**
+ * ecu_calib_load() on calibration.txt text held in memory; name labels
+ * the report lines (NULL: "<text>"). Returns the number of keys applied,
+ * or -1 if out of memory.
+ */
+int ecu_calib_parse(const char *text, const char *name, ecu_calib_t *cal, FILE *report);
+/**
+ * FNV-1a over every calibration value (not the loader bookkeeping):
+ * equal hashes mean the same behaviour, e.g. for checkpoints.
+ */
+unsigned long long ecu_calib_hash(const ecu_calib_t *cal);
+/** Non-zero if the named key was present in the loaded file. */
+int ecu_calib_has(const ecu_calib_t *cal, const char *key);
+/**
+ * Sets one key from its text value with the loader's sanitising, then
+ * re-prepares cal. Returns 0, or -1 for an unknown key or rejected value.
+ */
+int ecu_calib_set(ecu_calib_t *cal, const char *key, const char *value);
+/**
+ * Recomputes cal->run from the public fields. ecu_calib_load() calls it;
+ * call it again after editing a calibration by hand. max_engine_speed must
+ * be positive.
+ */
+void ecu_calib_prepare(ecu_calib_t *cal);
+
 // ---------- SCR1 ----------
 int compute_engine_state(int ignition_switch);
 
@@ -153,7 +296,133 @@ int apply_bto_effective_acc(int acc_deg,
                             int bto_brake_deg,
                             int bto_acc_min_deg,
                             double bto_acc_scale);
-							
+
+// ---------- Fused step (SCR1..SCR11) ----------
+/** One input row; time is carried by the caller. */
+typedef struct {
+    int ignition_switch;
+    int acc_pedal_position;
+    int brake_pedal_position;
+    int current_gear;
+    int cruise_enable;
+    int cruise_target_speed;
+} ecu_input_t;
+
+/** Everything latched between rows, in one cache line. Zero = power-on. */
+typedef struct {
+    _Alignas(64) int engine_speed;  // last emitted speed (SCR8 / SCR10 reference)
+    int engine_state;               // last emitted state
+    int limp_mode;                  // SCR9 latch
+    int overlap_run_count;          // SCR9
+    int hard_cut_active;            // SCR10 latch
+    int hard_cut_cooldown;          // SCR10
+} ecu_state_t;
+
+/** Resets st to the power-on state (all zero). */
+void ecu_state_init(ecu_state_t *st);
+/**
+ * Runs the whole SCR1..SCR11 chain for one row and returns engine_speed;
+ * st->engine_state holds the row's engine_state afterwards. Bit-identical
+ * to compute_engine_state + update_limp_state + apply_bto_effective_acc +
+ * update_engine_speed_cc_drag_idle + apply_limp_cap + apply_rev_limiter +
+ * apply_slew_limit as chained by app.c.
+ */
+int ecu_step(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in);
+/**
+ * Same chain in integer-only Q ECU_Q_BITS arithmetic: the gear gains,
+ * cc_kp and idle_kp are rounded to the Q grid once, SCR11 reads the
+ * prepared bto_eff table, and every product and rounding works on 64-bit
+ * integers. From the same state, a row can differ from ecu_step() by one
+ * rpm where a value lands next to a .5 boundary (see tools/qreport.c);
+ * that row's speed then feeds the next one as prev.
+ */
+int ecu_step_q(const ecu_calib_t *cal, ecu_state_t *st, const ecu_input_t *in);
+
+// ---------- Batch (structure of arrays) ----------
+/** Input columns for ecu_run_batch(); every pointer must cover n rows. */
+typedef struct {
+    const int *ignition_switch;
+    const int *acc_pedal_position;
+    const int *brake_pedal_position;
+    const int *current_gear;
+    const int *cruise_enable;
+    const int *cruise_target_speed;
+} ecu_columns_t;
+
+/**
+ * Runs ecu_step() over rows [0, n) of in, writing engine_state[i] and
+ * engine_speed[i]. st carries over between calls, so a long trace can be
+ * fed in fixed-size blocks with the same result as one call.
+ */
+void ecu_run_batch(const ecu_calib_t *cal,
+                   ecu_state_t *st,
+                   const ecu_columns_t *in,
+                   size_t n,
+                   int *engine_state,
+                   int *engine_speed);
+/** ecu_run_batch() on ecu_step_q(). */
+void ecu_run_batch_q(const ecu_calib_t *cal,
+                     ecu_state_t *st,
+                     const ecu_columns_t *in,
+                     size_t n,
+                     int *engine_state,
+                     int *engine_speed);
+
+// ---------- Sensitivities (forward-mode dual numbers) ----------
+/** Calibration doubles ecu_step_sens() differentiates against. */
+enum {
+    ECU_SENS_CC_KP,
+    ECU_SENS_IDLE_KP,
+    ECU_SENS_GEAR_G1,               // .. ECU_SENS_GEAR_G1 + 4 for g5
+    ECU_SENS_BTO_ACC_SCALE = ECU_SENS_GEAR_G1 + 5,
+    ECU_NSENS
+};
+/** Calibration key of each ECU_SENS_* entry. */
+extern const char *const ECU_SENS_KEY[ECU_NSENS];
+
+/** d(engine_speed)/d(param) of the last emitted speed; zero = power-on. */
+typedef struct {
+    double d_speed[ECU_NSENS];
+} ecu_sens_t;
+
+/**
+ * ecu_step() that also carries sens forward: every stage propagates the
+ * derivative of its value. A clamp to a constant (pedal/BTO range, 0 and
+ * max_engine_speed, limp cap, rev hard/soft limits, the cc and idle step
+ * limits, a calibration value the loader clamped) zeroes it; a limit
+ * relative to the previous output (slew, hard-cut pull-down) passes the
+ * previous row's derivative on. Rounding to whole rpm is treated as the
+ * identity. The returned speed and st are exactly those of the double
+ * ecu_step() (the -DECU_FIXED_POINT kernel may differ by one rpm per row,
+ * see ecu_step_q()).
+ */
+int ecu_step_sens(const ecu_calib_t *cal, ecu_state_t *st, ecu_sens_t *sens, const ecu_input_t *in);
+
+// ---------- Runs of identical rows ----------
+/** count consecutive rows with the same engine_state and engine_speed. */
+typedef struct {
+    int engine_state;
+    int engine_speed;
+    long long count;
+} ecu_out_run_t;
+
+typedef void (*ecu_run_emit_fn)(void *ctx, const ecu_out_run_t *run);
+
+/**
+ * Same result as n ecu_step() calls on the same input row, without
+ * stepping them all: rows are stepped one by one until the state stops
+ * changing (the SCR9 overlap count may keep growing once limp is latched;
+ * it is advanced by the remaining rows), and the rest of the run is then
+ * one repeat of the last row. Results go to emit in row order, at most one
+ * call per stepped row. Returns the number of rows actually stepped.
+ */
+long long ecu_run_constant(const ecu_calib_t *cal,
+                           ecu_state_t *st,
+                           const ecu_input_t *in,
+                           long long n,
+                           ecu_run_emit_fn emit,
+                           void *ctx);
+
 // ---------- SCR12 (BTO release ramp) ----------
 int parse_bto_release_params(const char *calib_path,
                              int *bto_release_ramp_rows,
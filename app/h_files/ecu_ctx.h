@@ -0,0 +1,48 @@
+#ifndef ECU_CTX_H
+#define ECU_CTX_H
+
+#include <stddef.h>
+#include "ecu.h"
+
+// ---------- libecu: embeddable ECU ----------
+// An ecu_ctx owns a copy of its calibration and its latched state, and
+// nothing in libecu has global mutable state: any number of contexts may
+// run at once, each on one thread at a time. Built as libecu.a and
+// libecu.so by `make lib`.
+typedef struct ecu_ctx ecu_ctx;
+
+/** One output row. */
+typedef struct {
+    int engine_state;
+    int engine_speed;
+} ecu_output_t;
+
+/**
+ * Creates a context from a calibration.txt file. Unknown, duplicate and
+ * malformed lines are described on report if non-NULL. NULL if the file
+ * cannot be read or memory runs out.
+ */
+ecu_ctx *ecu_ctx_open(const char *calib_path, FILE *report);
+/** Same, from calibration.txt text held in memory. */
+ecu_ctx *ecu_ctx_open_text(const char *calib_text, FILE *report);
+/** Same, from a calibration already loaded or built (copied). */
+ecu_ctx *ecu_ctx_create(const ecu_calib_t *cal);
+void ecu_ctx_free(ecu_ctx *ctx);
+
+/** Back to the power-on state; the calibration is kept. */
+void ecu_ctx_reset(ecu_ctx *ctx);
+/** The calibration in use. */
+const ecu_calib_t *ecu_ctx_calib(const ecu_ctx *ctx);
+/** Latched state, e.g. to snapshot and later restore with ecu_ctx_set_state(). */
+ecu_state_t ecu_ctx_state(const ecu_ctx *ctx);
+void ecu_ctx_set_state(ecu_ctx *ctx, const ecu_state_t *st);
+
+/** Runs one input row; same result as the ecu_app row. */
+ecu_output_t ecu_ctx_step(ecu_ctx *ctx, const ecu_input_t *in);
+/** n rows, in order, from an array of rows. */
+void ecu_ctx_step_batch(ecu_ctx *ctx, const ecu_input_t *in, size_t n, ecu_output_t *out);
+/** n rows from input columns (see ecu_run_batch()). */
+void ecu_ctx_run_columns(ecu_ctx *ctx, const ecu_columns_t *in, size_t n,
+                         int *engine_state, int *engine_speed);
+
+#endif
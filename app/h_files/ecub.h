@@ -0,0 +1,98 @@
+#ifndef ECUB_H
+#define ECUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------- Binary columnar trace format (.ecub) ----------
+//
+// Layout (little-endian, every section starts on a 64-byte boundary):
+//   ecub_header_t
+//   ecub_col_desc_t[ncols]                      schema
+//   blocks:
+//     ecub_block_header_t
+//     ecub_range_t[ncols]                       per-column min/max
+//     column 0 .. ncols-1                       rows * width bytes each
+//
+// Columns are fixed-width arrays, so a mapped file can feed the step
+// loop through plain pointers with no decoding.
+
+#define ECUB_MAGIC       "ECUB"
+#define ECUB_VERSION     1
+#define ECUB_ENDIAN_TAG  0x01020304u
+#define ECUB_ALIGN       64
+#define ECUB_BLOCK_ROWS  4096
+#define ECUB_NAME_LEN    32
+
+typedef enum {
+    ECUB_I32 = 1,
+    ECUB_I64 = 2
+} ecub_type_t;
+
+typedef struct {
+    char     magic[4];
+    uint32_t endian;        // ECUB_ENDIAN_TAG as written by the producer
+    uint16_t version;
+    uint16_t ncols;
+    uint32_t block_rows;    // largest block in the file
+    uint64_t rows;          // total rows
+    uint64_t nblocks;
+    uint8_t  reserved[32];
+} ecub_header_t;
+
+typedef struct {
+    char     name[ECUB_NAME_LEN];
+    uint32_t type;          // ecub_type_t
+    uint32_t reserved;
+} ecub_col_desc_t;
+
+typedef struct {
+    uint32_t rows;
+    uint32_t reserved;
+    uint64_t bytes;         // whole block, header included
+} ecub_block_header_t;
+
+typedef struct {
+    int64_t min, max;
+} ecub_range_t;
+
+/** Input trace schema (what csv2bin writes), in CSV column order. */
+extern const ecub_col_desc_t ECUB_INPUT_SCHEMA[7];
+/** Output trace schema: time, engine_state, engine_speed. */
+extern const ecub_col_desc_t ECUB_OUTPUT_SCHEMA[3];
+
+/** Nonzero if the len bytes at base start with an ECUB header. */
+int ecub_is(const void *base, size_t len);
+
+// ---------- Reader (over a caller-owned mapping) ----------
+typedef struct ecub_reader ecub_reader_t;
+
+/**
+ * Validates the header and schema of the len bytes at base. The memory
+ * must outlive the reader. Returns 0, or -1 with a message on stderr.
+ */
+int ecub_open_mem(const void *base, size_t len, const char *name, ecub_reader_t **out);
+int ecub_ncols(const ecub_reader_t *r);
+const ecub_col_desc_t *ecub_desc(const ecub_reader_t *r, int col);
+/** Column index by name, or -1. */
+int ecub_col(const ecub_reader_t *r, const char *name);
+/**
+ * Advances to the next block and points cols[i] at its column data.
+ * Returns the block's row count, 0 at the end (or -1 on a corrupt block).
+ */
+long ecub_next(ecub_reader_t *r, const void *cols[]);
+/** Min/max of a column in the current block. */
+ecub_range_t ecub_range(const ecub_reader_t *r, int col);
+void ecub_close(ecub_reader_t *r);
+
+// ---------- Writer ----------
+typedef struct ecub_writer ecub_writer_t;
+
+/** Creates path with the given schema; NULL (errno set) on failure. */
+ecub_writer_t *ecub_create(const char *path, const ecub_col_desc_t *schema, int ncols);
+/** Appends one block of n rows (n <= ECUB_BLOCK_ROWS); 0 or -1. */
+int ecub_write_block(ecub_writer_t *w, size_t n, const void *const cols[]);
+/** Writes the final header and closes; 0, or -1 if any write failed. */
+int ecub_finish(ecub_writer_t *w);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Fleet mode ----------
+/**
+ * Simulates every trace named by source with one shared, read-only
+ * calibration. source is either a directory (every *.csv, *.csv.gz and
+ * *.csv.zst except *_out.csv) or a manifest file listing one input path
+ * per line ('#' comments).
+ * Each output is written next to its input as <stem>_out.csv. Per-file
+ * timings and the aggregate rows/sec go to report. nthreads <= 0 uses one
+ * worker per core. Returns 0 if every file succeeded, else the first
+ * failing file's sim_run_csv() code (or 2 if source is unusable).
+ */
+int fleet_run(const ecu_calib_t *cal, const char *source, int nthreads, FILE *report);
+
+#endif
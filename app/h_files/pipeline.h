@@ -0,0 +1,28 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include "ecu.h"
+#include "writer.h"
+
+// ---------- Three-stage pipelined run ----------
+/**
+ * sim_run_csv() split over three threads: one parses blocks of rows, the
+ * calling thread runs the step chain on them, and one formats and writes
+ * the results. Blocks travel parse -> compute -> write and back to parse
+ * through lock-free single-producer/single-consumer rings, so a fixed set
+ * of blocks bounds the memory in flight and a slow stage holds the
+ * others back. Output is identical to sim_run_csv(); a 'repeat' input
+ * runs through sim_run_csv() itself.
+ *
+ * report gets one line with how often, and for how long, each stage
+ * waited on the one before it (parse waits for a block the writer has
+ * finished with). Returns 0 or an ecu_app exit code.
+ */
+int pipeline_run(const ecu_calib_t *cal,
+                 const char *in_path,
+                 const char *out_path,
+                 writer_flush_t flush,
+                 FILE *report);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef POOL_H
+#define POOL_H
+
+// ---------- Work-stealing thread pool ----------
+// Each worker owns a queue and runs its tasks oldest first, in submission
+// order; when empty it steals the oldest task from another worker, so one
+// long task never strands the tasks queued behind it. Submitting the
+// longest tasks first therefore starts them first.
+typedef struct pool pool_t;
+typedef void (*pool_fn)(void *arg, int worker);
+
+/** Starts nthreads workers (<= 0: one per online core). NULL on failure. */
+pool_t *pool_create(int nthreads);
+/** Queues fn(arg, worker); tasks are dealt round-robin across workers. */
+int pool_submit(pool_t *pool, pool_fn fn, void *arg);
+/** Blocks until every submitted task has finished. */
+void pool_wait(pool_t *pool);
+/** Waits for outstanding tasks, then stops and frees the pool. */
+void pool_destroy(pool_t *pool);
+
+int  pool_size(const pool_t *pool);
+/** Number of tasks taken from another worker's deque so far. */
+long pool_steals(const pool_t *pool);
+
+/** Online core count (at least 1). */
+int pool_default_threads(void);
+
+#endif
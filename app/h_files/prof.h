@@ -0,0 +1,75 @@
+#ifndef PROF_H
+#define PROF_H
+
+// ---------- Stage profiling (build with -DECU_PROFILE) ----------
+// Without ECU_PROFILE every macro below expands to nothing.
+//
+// Per-row stages are timed on one row in PROF_SAMPLE_EVERY; block stages
+// (parse, write) on every block and spread over its rows. Ticks are TSC
+// cycles on x86-64, nanoseconds elsewhere. At exit the histograms go to
+// stderr and to $ECU_PROFILE_OUT (default ecu_profile.json).
+
+typedef enum {
+    PROF_PARSE = 0,         // input decode
+    PROF_IGNITION,          // SCR1 + ignition-off resets
+    PROF_LIMP,              // SCR9 plausibility
+    PROF_BTO,               // SCR11 effective accelerator
+    PROF_SPEED,             // SCR2..SCR7 baseline/cruise/drag/idle
+    PROF_LIMP_CAP,          // SCR9 cap
+    PROF_REV,               // SCR10 rev limiter
+    PROF_SLEW,              // SCR8 slew
+    PROF_WRITE,             // output encode + write
+    PROF_STAGES
+} prof_stage_t;
+
+#define PROF_SAMPLE_EVERY 64
+
+#ifdef ECU_PROFILE
+
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t prof_now(void) { return __rdtsc(); }
+#else
+#include <time.h>
+static inline uint64_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+/** Registers the exit-time dump (idempotent). */
+void prof_init(void);
+/** Adds ticks spent on rows rows of stage. */
+void prof_add(prof_stage_t stage, uint64_t ticks, uint64_t rows);
+/** Nonzero for one call in PROF_SAMPLE_EVERY on this thread. */
+int prof_sample(void);
+
+#define PROF_INIT()             prof_init()
+#define PROF_BLOCK_BEGIN(name)  uint64_t name = prof_now()
+#define PROF_BLOCK_END(name, stage, rows) prof_add((stage), prof_now() - (name), (rows))
+
+// Per-row laps: PROF_ROW_BEGIN() once, then PROF_LAP(stage) after each stage.
+#define PROF_ROW_BEGIN()                                                \
+    const int prof_on_ = prof_sample();                                 \
+    uint64_t prof_last_ = prof_on_ ? prof_now() : 0
+#define PROF_LAP(stage)                                                 \
+    do {                                                                \
+        if (prof_on_) {                                                 \
+            prof_add((stage), prof_now() - prof_last_, 1);              \
+            prof_last_ = prof_now();  /* bookkeeping stays off the clock */ \
+        }                                                               \
+    } while (0)
+
+#else
+
+#define PROF_INIT()                         ((void)0)
+#define PROF_BLOCK_BEGIN(name)              ((void)0)
+#define PROF_BLOCK_END(name, stage, rows)   ((void)0)
+#define PROF_ROW_BEGIN()                    ((void)0)
+#define PROF_LAP(stage)                     ((void)0)
+
+#endif
+
+#endif
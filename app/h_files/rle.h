@@ -0,0 +1,39 @@
+#ifndef RLE_H
+#define RLE_H
+
+#include <stdio.h>
+#include "ecu.h"
+#include "writer.h"
+#include "trace_io.h"
+
+// ---------- Run-length fast-forward ----------
+typedef struct {
+    long long rows;         // input rows, repeats expanded
+    long long runs;         // runs of identical, time-contiguous input rows
+    long long stepped;      // rows actually put through the step chain
+} rle_stats_t;
+
+/**
+ * Simulates r into sink a run at a time: consecutive rows with identical
+ * inputs and contiguous times (and every 'repeat' row) form one run, and
+ * ecu_run_constant() stops stepping it once the state has settled. The
+ * output is identical to stepping every row. Returns 0, or 3 if the input
+ * stopped on a corrupt block.
+ */
+int rle_run_reader(const ecu_calib_t *cal, trace_reader_t *r, trace_sink_t *sink,
+                   rle_stats_t *stats);
+
+/**
+ * --fast-forward / --rle: rle_run_reader() from in_path to out_path, which
+ * is run-length encoded (see trace_sink_open_rle()) when rle_out is set.
+ * Row, run and stepped-row counts go to report if non-NULL. Returns 0 or
+ * an ecu_app exit code.
+ */
+int rle_run(const ecu_calib_t *cal,
+            const char *in_path,
+            const char *out_path,
+            int rle_out,
+            writer_flush_t flush,
+            FILE *report);
+
+#endif
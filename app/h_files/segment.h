@@ -0,0 +1,27 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdio.h>
+#include "ecu.h"
+#include "writer.h"
+
+// ---------- Segmented (intra-trace) parallel run ----------
+/**
+ * Simulates one trace on several threads. An ignition-off row leaves
+ * ecu_state_t all zero, so the trace is cut at such rows, every segment
+ * starts from ecu_state_init() on the pool, and the results are written
+ * back in order: identical to sim_run_csv().
+ *
+ * If cal keeps the SCR9 limp latch across ignition-off
+ * (limp_clear_on_ignition_off == 0) the state does not resync and the
+ * trace runs as one serial segment. nthreads <= 0 uses every core.
+ * A one-line summary goes to report. Returns 0 or an ecu_app exit code.
+ */
+int segment_run(const ecu_calib_t *cal,
+                const char *in_path,
+                const char *out_path,
+                int nthreads,
+                writer_flush_t flush,
+                FILE *report);
+
+#endif
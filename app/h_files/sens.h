@@ -0,0 +1,24 @@
+#ifndef SENS_H
+#define SENS_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Parameter sensitivity ----------
+/**
+ * One replay of in_path through ecu_step_sens(): d(engine_speed)/d(param)
+ * for every ECU_SENS_KEY parameter, instead of two finite-difference
+ * replays per parameter.
+ *
+ * out_path (optional) receives time,engine_state,engine_speed and one
+ * d_<key> column per parameter. report gets one line per parameter with
+ * the mean, mean absolute and largest absolute derivative over the rows
+ * with the engine on, and the derivative at the last row. Returns 0 or an
+ * ecu_app exit code.
+ */
+int sens_run(const ecu_calib_t *cal,
+             const char *in_path,
+             const char *out_path,
+             FILE *report);
+
+#endif
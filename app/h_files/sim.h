@@ -0,0 +1,46 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "ecu.h"
+#include "writer.h"
+
+// ---------- CSV trace simulation ----------
+typedef struct {
+    long rows;              // data rows simulated
+} sim_stats_t;
+
+/**
+ * Simulates one input trace (CSV or .ecub) into an output trace (.ecub
+ * when out_path ends in ".ecub", CSV otherwise) with a read-only calibration.
+ * A CSV input with a 'repeat' column goes through rle_run_reader().
+ * Reentrant: safe to call from several threads with the same cal.
+ * flush picks the output flush policy (see writer.h).
+ * Returns 0, or the ecu_app exit code for the failure (3 open/read input,
+ * 4 open/write output, 5 empty input, 6 bad header).
+ */
+int sim_run_csv(const ecu_calib_t *cal,
+                const char *in_path,
+                const char *out_path,
+                writer_flush_t flush,
+                sim_stats_t *stats);
+
+/**
+ * Incremental sim_run_csv() for a CSV trace that keeps growing. Without
+ * ckpt_path on disk it runs from the top; otherwise it checks the
+ * checkpoint's calibration and header hashes, seeks to its byte offset,
+ * restores the state and appends the new rows to out_path. An
+ * unterminated last line is left for the next run. The checkpoint is
+ * rewritten at the end, unless the input stopped early on a corrupt
+ * stream (3; the old checkpoint stays). stats->rows counts only the new
+ * rows.
+ * Returns 0, an sim_run_csv() code, or 7 for an unusable or mismatched
+ * checkpoint.
+ */
+int sim_resume_csv(const ecu_calib_t *cal,
+                   const char *in_path,
+                   const char *out_path,
+                   writer_flush_t flush,
+                   const char *ckpt_path,
+                   sim_stats_t *stats);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Live streaming ----------
+#define STREAM_BUDGET_US 1000   // per-row latency budget reported against
+
+/**
+ * Runs rows as they arrive: in_path may be "-" (stdin) or a FIFO,
+ * out_path "-" (stdout). The header is read once, state is kept for the
+ * life of the stream, and every batch of received rows is written out
+ * before blocking for more input.
+ *
+ * Per-row latency is measured from the read() that delivered the row to
+ * the write() of its output; p50/p99/max and the count over
+ * STREAM_BUDGET_US go to report at end of input. Returns 0 or an ecu_app
+ * exit code.
+ *
+ * With calib_path, the calibration file is watched for the life of the
+ * stream (calwatch.h): a new version takes effect between two batches of
+ * rows, the latched state carries over, and the row it took effect at is
+ * logged on stderr.
+ */
+int stream_run(const ecu_calib_t *cal,
+               const char *calib_path,
+               const char *in_path,
+               const char *out_path,
+               FILE *report);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Calibration sweep ----------
+/**
+ * Runs one trace against many calibration variants in lockstep: the input
+ * is parsed once and each row advances every variant through a
+ * structure-of-arrays kernel with one SIMD lane per variant.
+ *
+ * spec is either a manifest file (one calibration file per line) or a grid
+ * over base, e.g. "cc_kp=0.1:0.5:0.1,rev_soft_limit=1600:1800:100"
+ * (start:stop:step per key, cartesian product).
+ *
+ * out_path (optional) receives time,engine_state and one engine_speed
+ * column per variant, bit-identical to a separate ecu_app run with that
+ * calibration. A per-variant summary goes to report. Returns 0 or an
+ * ecu_app exit code.
+ */
+int sweep_run(const ecu_calib_t *base,
+              const char *spec,
+              const char *in_path,
+              const char *out_path,
+              FILE *report);
+
+/**
+ * One calibration through the same lane kernel from power-on, for
+ * differential testing against ecu_step(): engine_state[i] and
+ * engine_speed[i] for in[i]. Returns 0, or -1 when out of memory.
+ */
+int sweep_run_rows(const ecu_calib_t *cal, const ecu_input_t *in, size_t n,
+                   int *engine_state, int *engine_speed);
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef TRACE_IO_H
+#define TRACE_IO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ecu.h"
+#include "writer.h"
+
+// ---------- CSV trace input / output ----------
+#define TRACE_BLOCK_ROWS 4096
+
+/** One block of decoded rows (structure of arrays) and its results. */
+typedef struct {
+    size_t n;
+    int64_t t[TRACE_BLOCK_ROWS];
+    int  ign[TRACE_BLOCK_ROWS];
+    int  acc[TRACE_BLOCK_ROWS];
+    int  brk[TRACE_BLOCK_ROWS];
+    int  gear[TRACE_BLOCK_ROWS];
+    int  cc_en[TRACE_BLOCK_ROWS];
+    int  cc_tgt[TRACE_BLOCK_ROWS];
+    int  rep[TRACE_BLOCK_ROWS];         // 'repeat' column, >= 1
+    int  engine_state[TRACE_BLOCK_ROWS];
+    int  engine_speed[TRACE_BLOCK_ROWS];
+} trace_block_t;
+
+/** Input columns of blk, ready for ecu_run_batch(). */
+ecu_columns_t trace_block_columns(const trace_block_t *blk);
+
+typedef struct trace_reader trace_reader_t;
+
+/** Zero-copy view of the next rows of a binary (.ecub) input. */
+typedef struct {
+    size_t n;
+    const int64_t *t;
+    ecu_columns_t in;
+} trace_view_t;
+
+/**
+ * Opens an input trace: CSV, or .ecub (recognised by its magic; regular
+ * files only). gzip / zstd CSV (also by magic, see zio.h) is inflated on
+ * its own thread ahead of the reader. "-" reads stdin. Missing columns take the SCR defaults (gear 3, everything
+ * else 0; time counts rows; repeat 1). Returns 0, or the ecu_app exit code: 3
+ * cannot open, 5 empty input, 6 no 'ignition_switch' column / bad
+ * schema. Errors are described on stderr.
+ */
+int trace_open(const char *path, trace_reader_t **out);
+/** Decodes up to TRACE_BLOCK_ROWS rows into blk; returns blk->n (0 at EOF). */
+size_t trace_read_block(trace_reader_t *r, trace_block_t *blk);
+/**
+ * For live input (pipes, FIFOs): decodes the rows already received,
+ * blocking only while none is. Returns blk->n, 0 at EOF.
+ */
+size_t trace_read_ready(trace_reader_t *r, trace_block_t *blk);
+/**
+ * CLOCK_MONOTONIC ns at which the last read() returned data; for a mapped
+ * regular file, at which the last trace_read_ready() call started.
+ */
+int64_t trace_ready_ns(const trace_reader_t *r);
+/**
+ * Nonzero if the CSV header has a 'repeat' column: each row then stands
+ * for rep[i] rows at times t, t+1, ... (run-length encoded input).
+ */
+int trace_has_repeat(const trace_reader_t *r);
+/** Nonzero if r reads a mapped .ecub file (trace_view_next() works). */
+int trace_is_binary(const trace_reader_t *r);
+/**
+ * Binary inputs only: points v at up to TRACE_BLOCK_ROWS next rows inside
+ * the mapping, without copying. Returns v->n, 0 at EOF.
+ */
+size_t trace_view_next(trace_reader_t *r, trace_view_t *v);
+/** Byte offset just past the last row consumed (CSV inputs). */
+uint64_t trace_offset(const trace_reader_t *r);
+/** FNV-1a of the CSV header line, to tell whether a checkpoint fits. */
+uint64_t trace_header_hash(const trace_reader_t *r);
+/** Leaves an unterminated last line unread: it may still be being appended. */
+void trace_hold_partial(trace_reader_t *r);
+/**
+ * Continues a CSV input at byte offset (from trace_offset()) with rows
+ * already counted. Returns 0, or -1 for binary, unseekable or shorter
+ * inputs.
+ */
+int trace_resume(trace_reader_t *r, uint64_t offset, long rows);
+/** Nonzero if reading stopped early on a corrupt .ecub block or compressed stream. */
+int trace_failed(const trace_reader_t *r);
+/** Rows decoded so far ('repeat' rows count repeat times). */
+long trace_rows(const trace_reader_t *r);
+void trace_close(trace_reader_t *r);
+/** Length of path without its .csv / .csv.gz / .csv.zst suffix; -1 if it has none. */
+long trace_csv_stem(const char *path);
+/**
+ * One fgets() line of a manifest (one path per line, '#' comments), trimmed
+ * in place: the path, or NULL for a blank or comment line.
+ */
+char *trace_manifest_entry(char *line);
+
+// ---------- Output sink ----------
+typedef struct trace_sink trace_sink_t;
+
+/**
+ * Creates an output trace: .ecub when path ends in ".ecub", CSV
+ * (time,engine_state,engine_speed) otherwise, gzip / zstd compressed
+ * when it ends in ".gz" / ".zst"; "-" is CSV on stdout.
+ * flush applies to CSV.
+ * Returns NULL (errno set) on failure.
+ */
+trace_sink_t *trace_sink_open(const char *path, writer_flush_t flush);
+/**
+ * Run-length encoded CSV output (time,engine_state,engine_speed,repeat):
+ * consecutive rows with the same results and contiguous times collapse
+ * into one line. Not available for .ecub (NULL, errno ENOTSUP).
+ */
+trace_sink_t *trace_sink_open_rle(const char *path, writer_flush_t flush);
+/** Reopens an existing CSV output for appending, without a header. */
+trace_sink_t *trace_sink_append(const char *path, writer_flush_t flush);
+/** Appends n result rows. */
+void trace_sink_write(trace_sink_t *s, size_t n, const int64_t *t,
+                      const int *engine_state, const int *engine_speed);
+/**
+ * Appends count rows at times t, t+1, ... with the same results; one
+ * line on an RLE sink, count rows otherwise.
+ */
+void trace_sink_write_run(trace_sink_t *s, int64_t t, int engine_state, int engine_speed,
+                          long long count);
+/** Pushes buffered CSV rows out now. */
+void trace_sink_flush(trace_sink_t *s);
+/** Flushes and closes; 0, or -1 if any write failed. */
+int trace_sink_close(trace_sink_t *s);
+
+#endif
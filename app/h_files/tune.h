@@ -0,0 +1,38 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdio.h>
+#include "ecu.h"
+
+// ---------- Controller auto-tuner ----------
+/**
+ * Searches cc_kp, cc_max_step_per_iter, idle_kp and idle_max_step_per_iter
+ * for the lowest cost over a set of reference traces, everything else held
+ * at base. source is a trace (*.csv, *.csv.gz, *.csv.zst or *.ecub), a
+ * directory (every such CSV except *_out.csv*) or a manifest listing one
+ * trace per line. The traces are parsed once and shared read-only by
+ * every candidate.
+ *
+ * Cost, summed over the traces: each stretch of rows where the cruise or
+ * idle controller is engaged on one target is an episode, charged
+ * overshoot * (peak rpm past the target, on the far side from where the
+ * episode started) + settle * (rows until engine_speed stays within the
+ * settling band), plus revcut * (rows with the SCR10 hard cut latched).
+ * weights is "overshoot=W,settle=W,revcut=W" (any subset; NULL: all 1).
+ *
+ * The search is a grid refined around the best point each round, every
+ * candidate a task on a thread pool of nthreads workers (<= 0: one per
+ * core). The base itself is scored as loaded. Only if a candidate beats
+ * it does out_path receive base_path's text with the four keys replaced
+ * (or appended); otherwise out_path is left untouched. Per-round progress
+ * goes to report. Returns 0 or an ecu_app exit code.
+ */
+int tune_run(const ecu_calib_t *base,
+             const char *base_path,
+             const char *source,
+             const char *out_path,
+             const char *weights,
+             int nthreads,
+             FILE *report);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------- Buffered output stage ----------
+/** When the writer hands its buffer to the kernel. */
+typedef enum {
+    WRITER_FLUSH_BATCH = 0,     // only when the buffer is full (default)
+    WRITER_FLUSH_ROW,           // after every row, for live consumers
+    WRITER_FLUSH_DIRECT         // O_DIRECT, page-aligned full-buffer writes
+} writer_flush_t;
+
+#define WRITER_BUF_BYTES (1u << 20)
+
+typedef struct writer writer_t;
+
+/**
+ * Creates/truncates path for writing ("-" writes stdout). WRITER_FLUSH_DIRECT
+ * falls back to a normal open when the filesystem refuses O_DIRECT. A ".gz" /
+ * ".zst" path is compressed on every flush (ENOTSUP if the build lacks it;
+ * direct degrades to batch). Returns NULL (errno set) on failure.
+ */
+writer_t *writer_open(const char *path, writer_flush_t policy);
+/** Opens an existing file for appending (direct degrades to batch). */
+writer_t *writer_append(const char *path, writer_flush_t policy);
+/** Parses "batch" / "row" / "direct"; returns -1 for anything else. */
+int writer_parse_policy(const char *name);
+
+void writer_bytes(writer_t *w, const char *s, size_t n);
+void writer_str(writer_t *w, const char *s);
+void writer_char(writer_t *w, char c);
+/** Decimal, same digits as printf("%" PRId64). */
+void writer_i64(writer_t *w, int64_t v);
+/** Terminates a row with '\n' and applies the per-row flush policy. */
+void writer_row_end(writer_t *w);
+
+/** Hands everything buffered to the kernel now (whole pages under O_DIRECT). */
+void writer_flush(writer_t *w);
+/** Flushes and closes; returns 0, or -1 if any write failed. */
+int writer_close(writer_t *w);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef ZIO_H
+#define ZIO_H
+
+#include <stddef.h>
+
+// ---------- Compressed traces ----------
+// gzip needs a build with -DECU_WITH_ZLIB (-lz), zstd one with
+// -DECU_WITH_ZSTD (-lzstd); see the Makefile's ZLIB=1 / ZSTD=1.
+typedef enum {
+    ZIO_NONE = 0,
+    ZIO_GZIP,
+    ZIO_ZSTD
+} zio_format_t;
+
+/** Format of a stream whose first n bytes are at p, by magic bytes. */
+zio_format_t zio_detect(const void *p, size_t n);
+/** Output format for a file name: ".gz" gzip, ".zst" zstd, else none. */
+zio_format_t zio_from_path(const char *path);
+const char *zio_name(zio_format_t f);
+/** Nonzero if this build can read and write f. */
+int zio_supported(zio_format_t f);
+
+// ---------- Input: decompression thread ----------
+// A thread inflates the stream into fixed-size chunks and hands them over
+// through a bounded queue, so decompression overlaps with the row loop;
+// when the queue is full the thread waits for the reader to catch up.
+typedef struct zin zin_t;
+
+/**
+ * Starts decompressing: first the n bytes at data, then the rest of fd.
+ * With fd >= 0 data is copied (bytes already read while sniffing the
+ * magic); with fd < 0 data is the whole stream (e.g. a mapping) and must
+ * stay valid until zin_close(). NULL on failure.
+ */
+zin_t *zin_open(zio_format_t f, const void *data, size_t n, int fd);
+/**
+ * Copies up to cap decompressed bytes into dst, blocking while none is
+ * ready. Returns the byte count, 0 at the end of the stream, or -1 if it
+ * is corrupt or truncated.
+ */
+long zin_read(zin_t *z, void *dst, size_t cap);
+/** Stops the thread and frees z (fd is left open). */
+void zin_close(zin_t *z);
+
+// ---------- Output ----------
+typedef struct zout zout_t;
+
+/** Compresses into fd (left open by zout_close()). NULL on failure. */
+zout_t *zout_open(zio_format_t f, int fd);
+/**
+ * Compresses n bytes and writes what is ready; flush also pushes out a
+ * decodable boundary (for row-by-row consumers). Returns 0 or -1.
+ */
+int zout_write(zout_t *z, const void *p, size_t n, int flush);
+/** Ends the stream and frees z; 0, or -1 if any write failed. */
+int zout_close(zout_t *z);
+
+#endif
@@ -0,0 +1,114 @@
+// app/tools/benchrun.c — end-to-end ecu_app throughput over a generated trace
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define REPEATS 3   // best of
+
+typedef struct {
+    const char *name;
+    const char *args[6];        // after ./ecu_app; "%in"/"%out" are replaced
+    const char *in_ext;
+    const char *out_ext;
+} bench_case_t;
+
+static const bench_case_t CASES[] = {
+    { "csv",      { "%in", "%out", NULL },                 ".csv",  ".csv"  },
+    { "ecub",     { "%in", "%out", NULL },                 ".ecub", ".ecub" },
+    { "parallel", { "--parallel", "%in", "%out", NULL },   ".csv",  ".csv"  },
+};
+
+typedef struct {
+    double wall_s;
+    long   peak_rss_kb;
+    int    rc;
+} bench_result_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// One ecu_app run; rusage from wait4() gives the child's own peak RSS.
+static bench_result_t run_once(const bench_case_t *c, const char *in, const char *out) {
+    bench_result_t res = { 0.0, 0, -1 };
+    const char *argv[8];
+    int n = 0;
+    argv[n++] = "./ecu_app";
+    for (int i = 0; c->args[i]; i++) {
+        const char *a = c->args[i];
+        argv[n++] = strcmp(a, "%in") == 0 ? in : (strcmp(a, "%out") == 0 ? out : a);
+    }
+    argv[n] = NULL;
+
+    double t0 = now_seconds();
+    pid_t pid = fork();
+    if (pid < 0) return res;
+    if (pid == 0) {
+        execv(argv[0], (char *const *)argv);
+        _exit(127);
+    }
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) < 0) return res;
+    res.wall_s = now_seconds() - t0;
+    res.peak_rss_kb = ru.ru_maxrss;
+    res.rc = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return res;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <trace-stem> <rows> <results.json> [rev]\n", argv[0]);
+        return 2;
+    }
+    const char *stem = argv[1];
+    long rows = atol(argv[2]);
+    const char *json_path = argv[3];
+    const char *rev = argc > 4 ? argv[4] : "unknown";
+
+    // Run from app/: point ecu_app at the checked-in calibration.
+    setenv("ECU_CALIB_PATH", "calibration/calibration.txt", 0);
+
+    FILE *js = fopen(json_path, "w");
+    if (!js) { perror(json_path); return 4; }
+    fprintf(js, "{\n  \"rev\": \"%s\",\n  \"trace\": \"%s\",\n  \"rows\": %ld,\n  \"runs\": [", rev, stem, rows);
+
+    printf("%-10s %10s %14s %10s %12s\n", "case", "wall_s", "rows_per_s", "ns_per_row", "peak_rss_kb");
+    int failed = 0;
+    size_t ncases = sizeof(CASES) / sizeof(CASES[0]);
+    int emitted = 0;            // entries in the JSON array so far
+    for (size_t k = 0; k < ncases; k++) {
+        const bench_case_t *c = &CASES[k];
+        char in[1024], out[1024];
+        snprintf(in, sizeof(in), "%s%s", stem, c->in_ext);
+        snprintf(out, sizeof(out), "%s_%s_out%s", stem, c->name, c->out_ext);
+
+        bench_result_t best = { 0.0, 0, -1 };
+        for (int rep = 0; rep < REPEATS; rep++) {
+            bench_result_t r = run_once(c, in, out);
+            if (r.rc != 0) { best = r; break; }
+            if (best.rc != 0 || r.wall_s < best.wall_s) best = r;
+        }
+        if (best.rc != 0) {
+            fprintf(stderr, "benchrun: %s failed (rc=%d)\n", c->name, best.rc);
+            failed = 1;
+            continue;
+        }
+        double rps = best.wall_s > 0.0 ? (double)rows / best.wall_s : 0.0;
+        double nspr = rows > 0 ? best.wall_s * 1e9 / (double)rows : 0.0;
+        printf("%-10s %10.3f %14.0f %10.1f %12ld\n", c->name, best.wall_s, rps, nspr, best.peak_rss_kb);
+        fprintf(js, "%s\n    { \"name\": \"%s\", \"wall_s\": %.6f, \"rows_per_s\": %.0f, "
+                    "\"ns_per_row\": %.2f, \"peak_rss_kb\": %ld }",
+                emitted++ ? "," : "", c->name, best.wall_s, rps, nspr, best.peak_rss_kb);
+    }
+    fprintf(js, "\n  ]\n}\n");
+    fclose(js);
+    printf("benchrun: results in %s\n", json_path);
+    return failed;
+}
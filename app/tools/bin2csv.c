@@ -0,0 +1,76 @@
+// app/tools/bin2csv.c — any .ecub (input or output trace) -> CSV
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ecub.h"
+#include "writer.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <input.ecub> <output.csv>\n", argv[0]);
+        return 2;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        fprintf(stderr, "open input %s: %s\n", argv[1], strerror(errno));
+        return 3;
+    }
+    size_t len = (size_t)sb.st_size;
+    void *map = len ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: empty or unreadable input\n", argv[1]);
+        return 5;
+    }
+    madvise(map, len, MADV_SEQUENTIAL);
+
+    ecub_reader_t *r;
+    if (ecub_open_mem(map, len, argv[1], &r) != 0) { munmap(map, len); return 6; }
+
+    writer_t *w = writer_open(argv[2], WRITER_FLUSH_BATCH);
+    if (!w) {
+        fprintf(stderr, "open output %s: %s\n", argv[2], strerror(errno));
+        ecub_close(r); munmap(map, len);
+        return 4;
+    }
+
+    int ncols = ecub_ncols(r);
+    for (int i = 0; i < ncols; i++) {
+        if (i) writer_char(w, ',');
+        writer_str(w, ecub_desc(r, i)->name);
+    }
+    writer_row_end(w);
+
+    const void **cols = calloc((size_t)ncols, sizeof(*cols));
+    long n, rows = 0;
+    int rc = 0;
+    while (cols && (n = ecub_next(r, cols)) > 0) {
+        for (long k = 0; k < n; k++) {
+            for (int i = 0; i < ncols; i++) {
+                if (i) writer_char(w, ',');
+                if (ecub_desc(r, i)->type == ECUB_I64) writer_i64(w, ((const int64_t *)cols[i])[k]);
+                else                                  writer_i64(w, ((const int32_t *)cols[i])[k]);
+            }
+            writer_row_end(w);
+        }
+        rows += n;
+    }
+    if (!cols || n < 0) rc = 6;
+
+    free(cols);
+    ecub_close(r);
+    munmap(map, len);
+    if (writer_close(w) != 0) {
+        fprintf(stderr, "write output %s: %s\n", argv[2], strerror(errno));
+        return 4;
+    }
+    fprintf(stderr, "bin2csv: %ld rows\n", rows);
+    return rc;
+}
@@ -0,0 +1,65 @@
+// app/tools/csv2bin.c — input trace CSV -> .ecub
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "trace_io.h"
+#include "ecub.h"
+
+// .ecub has no 'repeat' column: run-length encoded rows are written out in full.
+static void expand_repeats(ecub_writer_t *w, const trace_block_t *blk) {
+    static trace_block_t out;
+    const void *cols[7] = { out.t, out.ign, out.acc, out.brk, out.gear, out.cc_en, out.cc_tgt };
+    for (size_t i = 0; i < blk->n; i++) {
+        for (int k = 0; k < blk->rep[i]; k++) {
+            size_t j = out.n++;
+            out.t[j]   = blk->t[i] + k;
+            out.ign[j] = blk->ign[i];
+            out.acc[j] = blk->acc[i];
+            out.brk[j] = blk->brk[i];
+            out.gear[j]   = blk->gear[i];
+            out.cc_en[j]  = blk->cc_en[i];
+            out.cc_tgt[j] = blk->cc_tgt[i];
+            if (out.n == TRACE_BLOCK_ROWS) { ecub_write_block(w, out.n, cols); out.n = 0; }
+        }
+    }
+    if (out.n) { ecub_write_block(w, out.n, cols); out.n = 0; }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <input.csv> <output.ecub>\n", argv[0]);
+        return 2;
+    }
+
+    trace_reader_t *r;
+    int rc = trace_open(argv[1], &r);
+    if (rc) return rc;
+
+    ecub_writer_t *w = ecub_create(argv[2], ECUB_INPUT_SCHEMA, 7);
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!w || !blk) {
+        fprintf(stderr, "open output %s: %s\n", argv[2], strerror(errno));
+        trace_close(r); ecub_finish(w); free(blk);
+        return 4;
+    }
+
+    // Missing CSV columns are written out with their defaults.
+    while (trace_read_block(r, blk) > 0) {
+        if (trace_has_repeat(r)) expand_repeats(w, blk);
+        else {
+            const void *cols[7] = { blk->t, blk->ign, blk->acc, blk->brk, blk->gear, blk->cc_en, blk->cc_tgt };
+            ecub_write_block(w, blk->n, cols);
+        }
+    }
+
+    long rows = trace_rows(r);
+    free(blk);
+    trace_close(r);
+    if (ecub_finish(w) != 0) {
+        fprintf(stderr, "write output %s: %s\n", argv[2], strerror(errno));
+        return 4;
+    }
+    fprintf(stderr, "csv2bin: %ld rows\n", rows);
+    return 0;
+}
@@ -0,0 +1,484 @@
+// app/tools/fuzzdiff.c — differential fuzzing of the step kernels against the SCR chain
+//
+// Each case is a random calibration (biased towards the edges the loader
+// still lets through: zeros, negatives, rev_soft_limit >= rev_hard_limit,
+// out-of-range gains) and a random input sequence built from short
+// stretches of uniform noise, clamp edges, ignition flapping, steady
+// holds, pedal overlap and cruise. The reference is the per-SCR chain
+// exactly as the original app.c called it; every kernel in KERNELS must
+// match it row for row (the Q kernel within its tolerance).
+//
+// A mismatch is shrunk (prefix up to the first bad row, chunk removal,
+// field simplification, calibration keys dropped) and written as a
+// testcase: <out>/SCR000099/case<seed>/{case<seed>.csv,golden.csv} plus
+// <out>/calibration/calib_scr99_case<seed>.txt.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "ecu.h"
+#include "ecu_ctx.h"
+#include "sweep.h"
+
+#define FUZZ_SCR       99
+#define FUZZ_MAX_ROWS  4096
+#define CAL_TEXT_MAX   4096
+
+typedef struct {
+    unsigned long long s;
+} rng_t;
+
+// splitmix64, as tracegen: same cases on every platform for a given seed.
+static unsigned long long rng_next(rng_t *r) {
+    unsigned long long z = (r->s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int rng_range(rng_t *r, int lo, int hi) {
+    return lo + (int)(rng_next(r) % (unsigned long long)(hi - lo + 1));
+}
+
+static int rng_pick(rng_t *r, const int *v, int n) {
+    return v[rng_next(r) % (unsigned long long)n];
+}
+
+// ======================== Reference chain ========================
+static void ref_run(const ecu_calib_t *c, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    int engine_speed = 0, limp_mode = 0, overlap_run_count = 0;
+    int hard_cut_active = 0, hard_cut_cooldown = 0;
+    for (size_t i = 0; i < n; i++) {
+        const ecu_input_t *r = &in[i];
+        int engine_state = compute_engine_state(r->ignition_switch);
+        update_limp_state(engine_state, r->acc_pedal_position, r->brake_pedal_position,
+                          c->acc_overlap_deg, c->brk_overlap_deg, c->limp_rows_confirm,
+                          c->limp_clear_on_ignition_off, &limp_mode, &overlap_run_count);
+        int prev_out = engine_speed;
+        int eff_acc = apply_bto_effective_acc(r->acc_pedal_position, r->brake_pedal_position,
+                                              c->bto_brake_deg, c->bto_acc_min_deg, c->bto_acc_scale);
+        int provisional = update_engine_speed_cc_drag_idle(
+            engine_state, eff_acc, r->brake_pedal_position, r->current_gear,
+            prev_out, c->max_engine_speed, c->brake_gain_rpm_per_deg, c->gear_mult,
+            r->cruise_enable, r->cruise_target_speed,
+            c->cc_kp, c->cc_max_step_per_iter, c->cc_activation_gear_min, c->cc_target_min, c->cc_target_max,
+            c->drag_rpm_per_iter,
+            c->idle_target_speed, c->idle_kp, c->idle_max_step_per_iter, c->idle_activation_gear_max);
+        provisional = apply_limp_cap(provisional, c->max_engine_speed, limp_mode, c->limp_max_speed);
+        provisional = apply_rev_limiter(engine_state, prev_out, provisional, c->max_engine_speed,
+                                        &hard_cut_active, &hard_cut_cooldown,
+                                        c->rev_soft_limit, c->rev_hard_limit, c->rev_hysteresis,
+                                        c->rev_hard_cut_step, c->rev_cut_cooldown_rows);
+        engine_speed = apply_slew_limit(engine_state, prev_out, provisional, c->max_engine_speed,
+                                        c->slew_max_rise_per_iter, c->slew_max_fall_per_iter);
+        out[i].engine_state = engine_state;
+        out[i].engine_speed = engine_speed;
+    }
+}
+
+// ======================== Kernels under test ========================
+typedef void (*kernel_fn)(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out);
+
+static void run_batch_with(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out,
+                           void (*batch)(const ecu_calib_t *, ecu_state_t *, const ecu_columns_t *,
+                                         size_t, int *, int *))
+{
+    static int col[6][FUZZ_MAX_ROWS], es[FUZZ_MAX_ROWS], spd[FUZZ_MAX_ROWS];
+    for (size_t i = 0; i < n; i++) {
+        col[0][i] = in[i].ignition_switch;
+        col[1][i] = in[i].acc_pedal_position;
+        col[2][i] = in[i].brake_pedal_position;
+        col[3][i] = in[i].current_gear;
+        col[4][i] = in[i].cruise_enable;
+        col[5][i] = in[i].cruise_target_speed;
+    }
+    const ecu_columns_t cols = { col[0], col[1], col[2], col[3], col[4], col[5] };
+    ecu_state_t st;
+    ecu_state_init(&st);
+    batch(cal, &st, &cols, n, es, spd);
+    for (size_t i = 0; i < n; i++) { out[i].engine_state = es[i]; out[i].engine_speed = spd[i]; }
+}
+
+static void k_batch(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    run_batch_with(cal, in, n, out, ecu_run_batch);
+}
+
+// Each row of ecu_step_q() starts from ecu_step()'s state, so a one-rpm
+// .5 difference is checked on its own row instead of compounding.
+static void k_step_q(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    ecu_state_t st;
+    ecu_state_init(&st);
+    for (size_t i = 0; i < n; i++) {
+        ecu_state_t sq = st;
+        out[i].engine_speed = ecu_step_q(cal, &sq, &in[i]);
+        out[i].engine_state = sq.engine_state;
+        ecu_step(cal, &st, &in[i]);
+    }
+}
+
+static void k_ctx(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    ecu_ctx *ctx = ecu_ctx_create(cal);
+    if (!ctx) { memset(out, 0xff, n * sizeof(*out)); return; }
+    ecu_ctx_step_batch(ctx, in, n, out);
+    ecu_ctx_free(ctx);
+}
+
+static void k_sweep(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    static int es[FUZZ_MAX_ROWS], spd[FUZZ_MAX_ROWS];
+    if (sweep_run_rows(cal, in, n, es, spd) != 0) { memset(out, 0xff, n * sizeof(*out)); return; }
+    for (size_t i = 0; i < n; i++) { out[i].engine_state = es[i]; out[i].engine_speed = spd[i]; }
+}
+
+static void k_sens(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    ecu_state_t st;
+    ecu_state_init(&st);
+    ecu_sens_t sens;
+    memset(&sens, 0, sizeof(sens));
+    for (size_t i = 0; i < n; i++) {
+        out[i].engine_speed = ecu_step_sens(cal, &st, &sens, &in[i]);
+        out[i].engine_state = st.engine_state;
+    }
+}
+
+typedef struct {
+    ecu_output_t *out;
+} rle_sink_t;
+
+static void rle_emit(void *ctx, const ecu_out_run_t *run) {
+    rle_sink_t *s = ctx;
+    for (long long k = 0; k < run->count; k++) {
+        s->out->engine_state = run->engine_state;
+        s->out->engine_speed = run->engine_speed;
+        s->out++;
+    }
+}
+
+static void k_rle(const ecu_calib_t *cal, const ecu_input_t *in, size_t n, ecu_output_t *out) {
+    ecu_state_t st;
+    ecu_state_init(&st);
+    rle_sink_t s = { out };
+    size_t i = 0;
+    while (i < n) {
+        size_t j = i + 1;
+        while (j < n && memcmp(&in[j], &in[i], sizeof(in[i])) == 0) j++;
+        ecu_run_constant(cal, &st, &in[i], (long long)(j - i), rle_emit, &s);
+        i = j;
+    }
+}
+
+typedef struct {
+    const char *name;
+    kernel_fn   run;
+    int         tol_rpm;        // engine_speed gap allowed per row; engine_state must match
+} kernel_t;
+
+static const kernel_t KERNELS[] = {
+    { "batch", k_batch,  0 },
+    { "rle",   k_rle,    0 },
+    { "ctx",   k_ctx,    0 },
+    { "sweep", k_sweep,  0 },
+    { "sens",  k_sens,   0 },
+    { "q",     k_step_q, 1 },   // .5 ties on the Q grid (ecu_step_q())
+};
+#define NKERNELS ((int)(sizeof(KERNELS) / sizeof(KERNELS[0])))
+
+// ======================== Case generation ========================
+typedef struct {
+    char text[CAL_TEXT_MAX];    // calibration.txt lines
+    ecu_input_t in[FUZZ_MAX_ROWS];
+    size_t n;
+} fuzz_case_t;
+
+static void cal_line(char *text, const char *key, const char *fmt, double v) {
+    size_t len = strlen(text);
+    char val[64];
+    snprintf(val, sizeof(val), fmt, v);
+    snprintf(text + len, CAL_TEXT_MAX - len, "%s = %s\n", key, val);
+}
+
+static void gen_calib(rng_t *g, char *text) {
+    static const int small[] = { -3, 0, 1, 2, 3, 5, 10, 45, 50 };
+    static const int speed[] = { -100, 0, 1, 300, 600, 1000, 1800, 1950, 2000, 2100, 5000 };
+    static const double gain[] = { -0.5, 0.0, 0.25, 0.6, 1.0, 1.2, 2.5 };
+    static const double unit[] = { -0.2, 0.0, 0.3, 0.5, 1.0, 1.3 };
+    text[0] = '\0';
+
+    // Each key is left at its default half of the time.
+#define MAYBE if (rng_next(g) & 1)
+#define SMALL (rng_pick(g, small, 9) + (rng_next(g) % 4 == 0 ? rng_range(g, 0, 60) : 0))
+#define SPEED (rng_pick(g, speed, 11) + (rng_next(g) % 4 == 0 ? rng_range(g, -50, 50) : 0))
+    MAYBE cal_line(text, "max_engine_speed", "%.0f", SPEED);
+    MAYBE cal_line(text, "brake_gain_rpm_per_deg", "%.0f", SMALL);
+    for (int k = 1; k <= 5; k++) {
+        char key[32];
+        snprintf(key, sizeof(key), "gear_acc_multiplier_g%d", k);
+        MAYBE cal_line(text, key, "%.3f", gain[rng_next(g) % 7] + (double)rng_range(g, 0, 99) / 1000.0);
+    }
+    MAYBE cal_line(text, "cc_kp", "%.3f", unit[rng_next(g) % 6] + (double)rng_range(g, 0, 99) / 1000.0);
+    MAYBE cal_line(text, "cc_max_step_per_iter", "%.0f", SMALL);
+    MAYBE cal_line(text, "cc_activation_gear_min", "%.0f", rng_range(g, -1, 7));
+    MAYBE cal_line(text, "cc_target_min", "%.0f", SPEED);
+    MAYBE cal_line(text, "cc_target_max", "%.0f", SPEED);
+    MAYBE cal_line(text, "drag_rpm_per_iter", "%.0f", SMALL);
+    MAYBE cal_line(text, "idle_target_speed", "%.0f", SPEED);
+    MAYBE cal_line(text, "idle_kp", "%.3f", unit[rng_next(g) % 6] + (double)rng_range(g, 0, 99) / 1000.0);
+    MAYBE cal_line(text, "idle_max_step_per_iter", "%.0f", SMALL);
+    MAYBE cal_line(text, "idle_activation_gear_max", "%.0f", rng_range(g, -1, 7));
+    MAYBE cal_line(text, "slew_max_rise_per_iter", "%.0f", SMALL * 4);
+    MAYBE cal_line(text, "slew_max_fall_per_iter", "%.0f", SMALL * 4);
+    MAYBE cal_line(text, "acc_overlap_deg", "%.0f", SMALL);
+    MAYBE cal_line(text, "brk_overlap_deg", "%.0f", SMALL);
+    MAYBE cal_line(text, "limp_rows_confirm", "%.0f", rng_range(g, -1, 6));
+    MAYBE cal_line(text, "limp_max_speed", "%.0f", SPEED);
+    MAYBE cal_line(text, "limp_acc_gain_scale", "%.2f", unit[rng_next(g) % 6]);
+    MAYBE cal_line(text, "limp_clear_on_ignition_off", "%.0f", rng_range(g, -1, 2));
+    int hard = SPEED;
+    MAYBE cal_line(text, "rev_hard_limit", "%.0f", hard);
+    if (rng_next(g) % 4 == 0) cal_line(text, "rev_soft_limit", "%.0f", hard + rng_range(g, 0, 200));
+    else MAYBE cal_line(text, "rev_soft_limit", "%.0f", SPEED);
+    MAYBE cal_line(text, "rev_hysteresis", "%.0f", SMALL * 5);
+    MAYBE cal_line(text, "rev_hard_cut_step", "%.0f", SMALL * 4);
+    MAYBE cal_line(text, "rev_cut_cooldown_rows", "%.0f", rng_range(g, -1, 8));
+    MAYBE cal_line(text, "bto_brake_deg", "%.0f", SMALL);
+    MAYBE cal_line(text, "bto_acc_min_deg", "%.0f", SMALL);
+    MAYBE cal_line(text, "bto_acc_scale", "%.3f", unit[rng_next(g) % 6] + (double)rng_range(g, 0, 99) / 1000.0);
+#undef MAYBE
+#undef SMALL
+#undef SPEED
+}
+
+static void gen_rows(rng_t *g, ecu_input_t *in, size_t n) {
+    static const int pedal_edge[] = { -1, 0, 1, 44, 45, 46 };
+    static const int gear_edge[]  = { -1, 0, 1, 5, 6 };
+    ecu_input_t cur = { 1, 0, 0, 3, 0, 0 };
+    size_t i = 0;
+    while (i < n) {
+        int mode = rng_range(g, 0, 5);
+        size_t len = (size_t)rng_range(g, 1, mode == 3 ? 400 : 48);
+        for (size_t k = 0; k < len && i < n; k++) {
+            switch (mode) {
+            case 0:     // uniform noise, well outside the valid ranges
+                cur.ignition_switch      = rng_next(g) % 16 ? 1 : 0;
+                cur.acc_pedal_position   = rng_range(g, -20, 70);
+                cur.brake_pedal_position = rng_range(g, -20, 70);
+                cur.current_gear         = rng_range(g, -2, 8);
+                cur.cruise_enable        = rng_range(g, -1, 2);
+                cur.cruise_target_speed  = rng_range(g, -200, 3000);
+                break;
+            case 1:     // clamp edges
+                cur.acc_pedal_position   = rng_pick(g, pedal_edge, 6);
+                cur.brake_pedal_position = rng_pick(g, pedal_edge, 6);
+                cur.current_gear         = rng_pick(g, gear_edge, 5);
+                break;
+            case 2:     // ignition flapping
+                cur.ignition_switch = rng_range(g, -1, 2);
+                break;
+            case 3:     // steady hold
+                break;
+            case 4:     // pedal overlap (SCR9 limp, SCR11 BTO)
+                cur.ignition_switch      = 1;
+                cur.acc_pedal_position   = rng_range(g, 0, 46);
+                cur.brake_pedal_position = rng_range(g, 5, 46);
+                break;
+            case 5:     // cruise around the target limits
+                cur.ignition_switch      = 1;
+                cur.acc_pedal_position   = 0;
+                cur.brake_pedal_position = 0;
+                cur.cruise_enable        = 1;
+                cur.current_gear         = rng_range(g, 2, 6);
+                cur.cruise_target_speed  = rng_range(g, -100, 2600);
+                break;
+            }
+            in[i++] = cur;
+        }
+    }
+}
+
+// ======================== Compare and shrink ========================
+static ecu_output_t ref_out[FUZZ_MAX_ROWS], got_out[FUZZ_MAX_ROWS];
+
+// First row where got_out differs from ref_out by more than tol rpm, or -1.
+static long compare(size_t n, int tol) {
+    for (size_t i = 0; i < n; i++) {
+        int d = got_out[i].engine_speed - ref_out[i].engine_speed;
+        if (ref_out[i].engine_state != got_out[i].engine_state || d > tol || d < -tol) return (long)i;
+    }
+    return -1;
+}
+
+// First row where kernel k differs from the reference, or -1.
+static long first_mismatch(const kernel_t *k, const char *text, const ecu_input_t *in, size_t n) {
+    ecu_calib_t cal;
+    ecu_calib_parse(text, "fuzz", &cal, NULL);
+    ref_run(&cal, in, n, ref_out);
+    k->run(&cal, in, n, got_out);
+    return compare(n, k->tol_rpm);
+}
+
+static void shrink(const kernel_t *k, fuzz_case_t *c) {
+    long bad = first_mismatch(k, c->text, c->in, c->n);
+    c->n = (size_t)bad + 1;     // later rows cannot matter
+
+    // Drop chunks of rows, halving the chunk size.
+    for (size_t chunk = c->n / 2; chunk >= 1; chunk /= 2) {
+        size_t i = 0;
+        while (i < c->n && c->n > 1) {
+            size_t m = chunk < c->n - i ? chunk : c->n - i;
+            if (m == c->n) break;
+            ecu_input_t saved[FUZZ_MAX_ROWS];
+            memcpy(saved, c->in + i, m * sizeof(*saved));
+            memmove(c->in + i, c->in + i + m, (c->n - i - m) * sizeof(*c->in));
+            if (first_mismatch(k, c->text, c->in, c->n - m) >= 0) {
+                c->n -= m;
+                continue;
+            }
+            memmove(c->in + i + m, c->in + i, (c->n - i - m) * sizeof(*c->in));
+            memcpy(c->in + i, saved, m * sizeof(*saved));
+            i += m;
+        }
+    }
+
+    // Simplify fields towards the SCR defaults.
+    static const int neutral[6] = { 1, 0, 0, 3, 0, 0 };
+    for (size_t i = 0; i < c->n; i++) {
+        int *f = &c->in[i].ignition_switch;
+        for (int j = 0; j < 6; j++) {
+            int was = f[j];
+            if (was == neutral[j]) continue;
+            f[j] = neutral[j];
+            if (first_mismatch(k, c->text, c->in, c->n) < 0) f[j] = was;
+        }
+    }
+
+    // Drop calibration lines that are not needed.
+    char *line = c->text;
+    while (*line) {
+        char *eol = strchr(line, '\n');
+        size_t len = eol ? (size_t)(eol - line) + 1 : strlen(line);
+        char saved[CAL_TEXT_MAX];
+        snprintf(saved, sizeof(saved), "%s", c->text);
+        memmove(line, line + len, strlen(line + len) + 1);
+        if (first_mismatch(k, c->text, c->in, c->n) < 0) {
+            snprintf(c->text, CAL_TEXT_MAX, "%s", saved);
+            line += len;
+        }
+    }
+    c->n = (size_t)first_mismatch(k, c->text, c->in, c->n) + 1;
+}
+
+static int write_case(const char *out_dir, unsigned long long seed, const fuzz_case_t *c) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/SCR%06d", out_dir, FUZZ_SCR);
+    mkdir(out_dir, 0777);
+    mkdir(path, 0777);
+    snprintf(path, sizeof(path), "%s/SCR%06d/case%llu", out_dir, FUZZ_SCR, seed);
+    mkdir(path, 0777);
+    snprintf(path, sizeof(path), "%s/calibration", out_dir);
+    mkdir(path, 0777);
+
+    ecu_calib_t cal;
+    ecu_calib_parse(c->text, "fuzz", &cal, NULL);
+    ref_run(&cal, c->in, c->n, ref_out);
+
+    snprintf(path, sizeof(path), "%s/SCR%06d/case%llu/case%llu.csv", out_dir, FUZZ_SCR, seed, seed);
+    FILE *fi = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s/SCR%06d/case%llu/golden.csv", out_dir, FUZZ_SCR, seed);
+    FILE *fg = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s/calibration/calib_scr%d_case%llu.txt", out_dir, FUZZ_SCR, seed);
+    FILE *fc = fopen(path, "w");
+    if (!fi || !fg || !fc) {
+        fprintf(stderr, "fuzzdiff: cannot write %s: %s\n", path, strerror(errno));
+        if (fi) fclose(fi);
+        if (fg) fclose(fg);
+        if (fc) fclose(fc);
+        return -1;
+    }
+    fprintf(fi, "time,ignition_switch,acc_pedal_position,brake_pedal_position,current_gear,cruise_enable,cruise_target_speed\n");
+    fprintf(fg, "time,engine_state,engine_speed\n");
+    for (size_t i = 0; i < c->n; i++) {
+        const ecu_input_t *r = &c->in[i];
+        fprintf(fi, "%zu,%d,%d,%d,%d,%d,%d\n", i, r->ignition_switch, r->acc_pedal_position,
+                r->brake_pedal_position, r->current_gear, r->cruise_enable, r->cruise_target_speed);
+        fprintf(fg, "%zu,%d,%d\n", i, ref_out[i].engine_state, ref_out[i].engine_speed);
+    }
+    fputs(c->text, fc);
+    fclose(fi);
+    fclose(fg);
+    fclose(fc);
+    return 0;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Non-zero if name is one of the comma-separated entries of list.
+static int has_token(const char *list, const char *name) {
+    const size_t n = strlen(name);
+    for (const char *p = list; ; p++) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == n && strncmp(p, name, n) == 0) return 1;
+        if (!end) return 0;
+        p = end;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <cases> <seed> [out-dir] [kernel,...]\n"
+                        "kernels: batch rle ctx sweep sens q (default: all)\n", argv[0]);
+        return 2;
+    }
+    long ncases = atol(argv[1]);
+    unsigned long long seed0 = strtoull(argv[2], NULL, 10);
+    const char *out_dir = argc > 3 ? argv[3] : "fuzz_cases";
+    const char *only = argc > 4 ? argv[4] : NULL;
+
+    int use[NKERNELS], nuse = 0;
+    for (int k = 0; k < NKERNELS; k++) {
+        use[k] = only ? has_token(only, KERNELS[k].name) : 1;
+        nuse += use[k];
+    }
+    if (nuse == 0) { fprintf(stderr, "fuzzdiff: no kernel matches '%s'\n", only); return 2; }
+
+    fuzz_case_t *c = malloc(sizeof(*c));
+    if (!c) return 2;
+    long rows = 0, failures = 0;
+    double t0 = now_s();
+    for (long i = 0; i < ncases; i++) {
+        unsigned long long seed = seed0 + (unsigned long long)i;
+        rng_t g = { seed };
+        gen_calib(&g, c->text);
+        c->n = (size_t)rng_range(&g, 1, FUZZ_MAX_ROWS);
+        gen_rows(&g, c->in, c->n);
+        rows += (long)c->n;
+
+        ecu_calib_t cal;
+        ecu_calib_parse(c->text, "fuzz", &cal, NULL);
+        ref_run(&cal, c->in, c->n, ref_out);
+        for (int k = 0; k < NKERNELS; k++) {
+            if (!use[k]) continue;
+            KERNELS[k].run(&cal, c->in, c->n, got_out);
+            if (compare(c->n, KERNELS[k].tol_rpm) < 0) continue;
+            failures++;
+            shrink(&KERNELS[k], c);
+            long bad = first_mismatch(&KERNELS[k], c->text, c->in, c->n);
+            fprintf(stderr, "fuzzdiff: seed %llu: kernel %s differs at row %ld "
+                            "(reference %d,%d, got %d,%d); %zu rows after shrinking\n",
+                    seed, KERNELS[k].name, bad, ref_out[bad].engine_state, ref_out[bad].engine_speed,
+                    got_out[bad].engine_state, got_out[bad].engine_speed, c->n);
+            write_case(out_dir, seed, c);
+            break;
+        }
+    }
+    double dt = now_s() - t0;
+    printf("fuzzdiff: %ld cases, %ld rows x %d kernels, %.1f Mrows/s, %ld mismatches\n",
+           ncases, rows, nuse, dt > 0 ? (double)rows * nuse / dt / 1e6 : 0.0, failures);
+    free(c);
+    return failures ? 1 : 0;
+}
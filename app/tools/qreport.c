@@ -0,0 +1,69 @@
+// app/tools/qreport.c — fixed-point (ecu_step_q) vs double (ecu_step) on the testcases
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ecu.h"
+#include "trace_io.h"
+#include "cases.h"
+
+#define MAX_ROWS_SHOWN 20
+
+int main(int argc, char *argv[]) {
+    const char *cases_dir = argc > 1 ? argv[1] : "../testcases";
+    const char *cal_dir   = argc > 2 ? argv[2] : "calibration";
+
+    ecu_case_t *cases;
+    int ncase_found = cases_find(cases_dir, cal_dir, &cases);
+    if (ncase_found < 0) {
+        fprintf(stderr, "qreport: no testcases under %s\n", cases_dir);
+        return 2;
+    }
+
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if (!blk) return 2;
+    printf("qreport: Q%d.%d (ecu_step_q) vs double (ecu_step)\n", 32 - ECU_Q_BITS, ECU_Q_BITS);
+
+    long total_rows = 0, total_diff = 0;
+    int max_abs = 0, ncases = 0;
+    for (int c = 0; c < ncase_found; c++) {
+        const ecu_case_t *tc = &cases[c];
+        const char *in_path = tc->input, *cal_path = tc->calib;
+
+        ecu_calib_t cal;
+        if (ecu_calib_load(cal_path, &cal, NULL) < 0) ecu_calib_defaults(&cal);
+
+        trace_reader_t *r;
+        if (trace_open(in_path, &r) != 0) continue;
+        ncases++;
+
+        ecu_state_t sd, sq;
+        ecu_state_init(&sd);
+        ecu_state_init(&sq);
+        long row = 0, diff = 0;
+        while (trace_read_block(r, blk) > 0) {
+            for (size_t i = 0; i < blk->n; i++, row++) {
+                ecu_input_t in = { blk->ign[i], blk->acc[i], blk->brk[i],
+                                   blk->gear[i], blk->cc_en[i], blk->cc_tgt[i] };
+                int d = ecu_step(&cal, &sd, &in);
+                int q = ecu_step_q(&cal, &sq, &in);
+                if (d == q) continue;
+                if (diff < MAX_ROWS_SHOWN) {
+                    printf("  %s row %ld t=%lld double=%d fixed=%d\n",
+                           tc->name, row, (long long)blk->t[i], d, q);
+                }
+                diff++;
+                if (abs(d - q) > max_abs) max_abs = abs(d - q);
+            }
+        }
+        trace_close(r);
+        printf("%s: rows=%ld diff_rows=%ld calib=%s\n", tc->name, row, diff, cal_path);
+        total_rows += row;
+        total_diff += diff;
+    }
+    free(cases);
+    free(blk);
+
+    printf("qreport: cases=%d rows=%ld diff_rows=%ld max_abs_diff=%d\n",
+           ncases, total_rows, total_diff, max_abs);
+    return total_diff ? 1 : 0;
+}
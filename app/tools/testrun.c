@@ -0,0 +1,265 @@
+// app/tools/testrun.c — runs every testcase in-process and diffs it against golden.csv
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "ecu.h"
+#include "trace_io.h"
+#include "cases.h"
+#include "pool.h"
+
+typedef struct {
+    char  *p;
+    size_t n, cap;
+} buf_t;
+
+typedef struct {
+    const ecu_case_t *tc;
+    int    pass;
+    int    expect_fail;         // listed in the --expect-fail file
+    long   rows;
+    char   why[512];            // first divergence, when failed
+} case_result_t;
+
+static int buf_reserve(buf_t *b, size_t more) {
+    if (b->n + more <= b->cap) return 0;
+    size_t ncap = b->cap ? b->cap * 2 : 4096;
+    while (ncap < b->n + more) ncap *= 2;
+    char *np = realloc(b->p, ncap);
+    if (!np) return -1;
+    b->p = np;
+    b->cap = ncap;
+    return 0;
+}
+
+static int buf_printf(buf_t *b, const char *fmt, long long t, int es, int spd) {
+    if (buf_reserve(b, 64) != 0) return -1;
+    b->n += (size_t)snprintf(b->p + b->n, 64, fmt, t, es, spd);
+    return 0;
+}
+
+static int slurp(const char *path, buf_t *b) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    char chunk[1 << 14];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        if (buf_reserve(b, got) != 0) { fclose(f); return -1; }
+        memcpy(b->p + b->n, chunk, got);
+        b->n += got;
+    }
+    fclose(f);
+    return 0;
+}
+
+// Offset of the first differing byte, eight bytes per compare; n if none.
+static size_t first_diff(const char *a, const char *b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return i + (size_t)(__builtin_ctzll(x ^ y) >> 3);
+#else
+            break;
+#endif
+        }
+    }
+    for (; i < n; i++) if (a[i] != b[i]) return i;
+    return n;
+}
+
+// Copies the CSV field containing off (or "<eof>") into out.
+static void field_at(const buf_t *b, size_t line_start, int field, char *out, size_t cap) {
+    const char *p = b->p + line_start, *end = b->p + b->n;
+    for (int f = 0; f < field && p < end; p++) if (*p == ',') f++;
+    const char *q = p;
+    while (q < end && *q != ',' && *q != '\n' && *q != '\r') q++;
+    if (p >= end) snprintf(out, cap, "<eof>");
+    else          snprintf(out, cap, "%.*s", (int)(q - p), p);
+}
+
+// Copies the line starting at line_start (or "<eof>") into out.
+static void line_at(const buf_t *b, size_t line_start, char *out, size_t cap) {
+    const char *p = b->p + line_start, *end = b->p + b->n;
+    const char *q = p;
+    while (q < end && *q != '\n' && *q != '\r') q++;
+    if (p >= end) snprintf(out, cap, "<eof>");
+    else          snprintf(out, cap, "%.*s", (int)(q - p), p);
+}
+
+// Describes the first divergence between got and want as row/field.
+static void describe_diff(const buf_t *got, const buf_t *want, char *why, size_t cap) {
+    size_t common = got->n < want->n ? got->n : want->n;
+    size_t off = first_diff(got->p, want->p, common);
+
+    long row = 0;                  // 0 = header
+    size_t line_start = 0;
+    for (size_t i = 0; i < off; i++) {
+        if (want->p[i] == '\n') { row++; line_start = i + 1; }
+    }
+    int field = 0;
+    for (size_t i = line_start; i < off; i++) if (want->p[i] == ',') field++;
+
+    static const char *const FIELD_NAME[3] = { "time", "engine_state", "engine_speed" };
+    char g[128], w[128];
+    field_at(got, line_start, field, g, sizeof(g));
+    field_at(want, line_start, field, w, sizeof(w));
+    if (row == 0 || strcmp(g, w) == 0) {
+        // Header, or a field-count/row-count difference: show whole lines.
+        line_at(got, line_start, g, sizeof(g));
+        line_at(want, line_start, w, sizeof(w));
+        if (row == 0) snprintf(why, cap, "header: got '%s' expected '%s'", g, w);
+        else          snprintf(why, cap, "row %ld: got '%s' expected '%s'", row, g, w);
+    } else {
+        snprintf(why, cap, "row %ld field %s: got %s expected %s", row,
+                 field < 3 ? FIELD_NAME[field] : "?", g, w);
+    }
+}
+
+static void run_case(void *arg, int worker) {
+    (void)worker;
+    case_result_t *res = arg;
+    const ecu_case_t *tc = res->tc;
+
+    ecu_calib_t cal;
+    if (ecu_calib_load(tc->calib, &cal, NULL) < 0) {
+        snprintf(res->why, sizeof(res->why), "cannot open %.400s", tc->calib);
+        return;
+    }
+
+    trace_reader_t *r;
+    if (trace_open(tc->input, &r) != 0) {
+        snprintf(res->why, sizeof(res->why), "cannot read %.400s", tc->input);
+        return;
+    }
+    trace_block_t *blk = malloc(sizeof(*blk));
+    buf_t got = { NULL, 0, 0 }, want = { NULL, 0, 0 };
+    if (!blk || buf_reserve(&got, 64) != 0) {
+        snprintf(res->why, sizeof(res->why), "out of memory");
+        goto done;
+    }
+    got.n = (size_t)snprintf(got.p, 64, "time,engine_state,engine_speed\n");
+
+    ecu_state_t st;
+    ecu_state_init(&st);
+    while (trace_read_block(r, blk) > 0) {
+        const ecu_columns_t cols = trace_block_columns(blk);
+        ecu_run_batch(&cal, &st, &cols, blk->n, blk->engine_state, blk->engine_speed);
+        for (size_t i = 0; i < blk->n; i++) {
+            buf_printf(&got, "%lld,%d,%d\n", (long long)blk->t[i], blk->engine_state[i], blk->engine_speed[i]);
+        }
+    }
+    res->rows = trace_rows(r);
+
+    if (slurp(tc->golden, &want) != 0) {
+        snprintf(res->why, sizeof(res->why), "cannot read %.400s", tc->golden);
+        goto done;
+    }
+    if (got.n == want.n && memcmp(got.p, want.p, got.n) == 0) {
+        res->pass = 1;
+    } else {
+        describe_diff(&got, &want, res->why, sizeof(res->why));
+    }
+
+done:
+    free(got.p);
+    free(want.p);
+    free(blk);
+    trace_close(r);
+}
+
+// Marks every case named in path (one SCRnnnnnn/caseN per line, '#'
+// comments). Returns the number of names that match no case, or -1 if
+// path cannot be read.
+static int load_expect_fail(const char *path, case_result_t *res, int n) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int unknown = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        size_t len = strlen(p);
+        while (len && (p[len-1] == '\n' || p[len-1] == '\r' || p[len-1] == ' ' || p[len-1] == '\t')) p[--len] = '\0';
+        if (len == 0 || p[0] == '#') continue;
+        int hit = 0;
+        for (int i = 0; i < n; i++) {
+            if (strcmp(res[i].tc->name, p) == 0) { res[i].expect_fail = 1; hit = 1; }
+        }
+        if (!hit) { fprintf(stderr, "testrun: %s: no testcase '%s'\n", path, p); unknown++; }
+    }
+    fclose(f);
+    return unknown;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+    const char *pos[2] = { "../testcases", "calibration" };
+    const char *expect_fail = NULL;
+    int npos = 0, threads = 0, verbose = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--expect-fail") == 0 && i + 1 < argc) expect_fail = argv[++i];
+        else if (strcmp(argv[i], "-v") == 0)                   verbose = 1;
+        else if (npos < 2)                                     pos[npos++] = argv[i];
+    }
+
+    ecu_case_t *cases;
+    int n = cases_find(pos[0], pos[1], &cases);
+    if (n <= 0) {
+        fprintf(stderr, "testrun: no testcases under %s\n", pos[0]);
+        return 2;
+    }
+    case_result_t *res = calloc((size_t)n, sizeof(*res));
+    pool_t *pool = pool_create(threads);
+    if (!res || !pool) { fprintf(stderr, "testrun: cannot start\n"); return 2; }
+
+    for (int i = 0; i < n; i++) res[i].tc = &cases[i];
+    int stale = 0;              // --expect-fail names that match no case
+    if (expect_fail && (stale = load_expect_fail(expect_fail, res, n)) < 0) {
+        fprintf(stderr, "testrun: cannot read %s\n", expect_fail);
+        pool_destroy(pool);
+        return 2;
+    }
+
+    double t0 = now_seconds();
+    for (int i = 0; i < n; i++) pool_submit(pool, run_case, &res[i]);
+    pool_wait(pool);
+    double wall = now_seconds() - t0;
+
+    // A listed case that fails is expected; one that passes is reported
+    // too, so the list shrinks as goldens are fixed.
+    int failed = 0, xfail = 0, xpass = 0;
+    long rows = 0;
+    for (int i = 0; i < n; i++) {
+        rows += res[i].rows;
+        if (res[i].pass && res[i].expect_fail) {
+            xpass++;
+            printf("XPASS %s: listed in %s but passes\n", res[i].tc->name, expect_fail);
+        } else if (res[i].pass) {
+            if (verbose) printf("PASS %s (%ld rows)\n", res[i].tc->name, res[i].rows);
+        } else if (res[i].expect_fail) {
+            xfail++;
+            if (verbose) printf("XFAIL %s: %s [calib %s]\n", res[i].tc->name, res[i].why, res[i].tc->calib);
+        } else {
+            failed++;
+            printf("FAIL %s: %s [calib %s]\n", res[i].tc->name, res[i].why, res[i].tc->calib);
+        }
+    }
+    printf("testrun: cases=%d passed=%d failed=%d expected_fail=%d unexpected_pass=%d rows=%ld threads=%d ms=%.2f\n",
+           n, n - failed - xfail, failed, xfail, xpass, rows, pool_size(pool), wall * 1e3);
+
+    pool_destroy(pool);
+    free(res);
+    free(cases);
+    return failed || xpass || stale ? 1 : 0;
+}
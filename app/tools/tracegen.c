@@ -0,0 +1,208 @@
+// app/tools/tracegen.c — seeded synthetic drive-cycle traces (CSV or .ecub)
+//
+// A trace is a run of trips. Each trip is ignition off, idle, then a
+// random sequence of driving phases until the trip length is used up:
+//   accel     pedal ramps to a target and holds, upshifting as it goes
+//   cruise    cruise_enable with a target, pedals released
+//   coast     everything released
+//   brake     brake ramps in, downshifting
+//   overlap   throttle and brake held together (drives SCR9 limp)
+//   overrev   full throttle in a low gear (drives the SCR10 limiter)
+// plus rare out-of-range pedal/gear samples to exercise the clamps.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "trace_io.h"
+#include "ecub.h"
+#include "writer.h"
+
+typedef enum { PH_IDLE, PH_ACCEL, PH_CRUISE, PH_COAST, PH_BRAKE, PH_OVERLAP, PH_OVERREV, PH_COUNT } phase_t;
+
+// Relative weights of the driving phases.
+static const int PHASE_WEIGHT[PH_COUNT] = { 14, 30, 20, 15, 16, 1, 4 };
+
+typedef struct {
+    unsigned long long s;
+} rng_t;
+
+// splitmix64: same sequence on every platform for a given seed.
+static unsigned long long rng_next(rng_t *r) {
+    unsigned long long z = (r->s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [lo, hi].
+static int rng_range(rng_t *r, int lo, int hi) {
+    return lo + (int)(rng_next(r) % (unsigned long long)(hi - lo + 1));
+}
+
+static int rng_chance(rng_t *r, int per_mille) {
+    return (int)(rng_next(r) % 1000) < per_mille;
+}
+
+static int step_toward(int v, int target, int rate) {
+    if (v < target) return v + rate < target ? v + rate : target;
+    if (v > target) return v - rate > target ? v - rate : target;
+    return v;
+}
+
+typedef struct {
+    rng_t  rng;
+    long   left_in_trip;        // rows of driving before the next ignition-off
+    long   left_in_phase;
+    int    off_rows;            // pending ignition-off rows
+    phase_t phase;
+    int    acc, brk, gear, cc_en, cc_tgt;
+    int    acc_target, brk_target, rate;
+} gen_t;
+
+static phase_t pick_phase(gen_t *g) {
+    int total = 0;
+    for (int p = 0; p < PH_COUNT; p++) total += PHASE_WEIGHT[p];
+    int x = rng_range(&g->rng, 0, total - 1);
+    for (int p = 0; p < PH_COUNT; p++) {
+        if (x < PHASE_WEIGHT[p]) return (phase_t)p;
+        x -= PHASE_WEIGHT[p];
+    }
+    return PH_IDLE;
+}
+
+static void start_phase(gen_t *g, phase_t p) {
+    rng_t *r = &g->rng;
+    g->phase = p;
+    g->cc_en = 0;
+    g->rate  = rng_range(r, 1, 3);
+    switch (p) {
+    case PH_IDLE:
+        g->left_in_phase = rng_range(r, 50, 300);
+        g->acc_target = 0; g->brk_target = 0; g->gear = rng_range(r, 1, 2);
+        break;
+    case PH_ACCEL:
+        g->left_in_phase = rng_range(r, 100, 1500);
+        g->acc_target = rng_range(r, 10, 45); g->brk_target = 0;
+        break;
+    case PH_CRUISE:
+        g->left_in_phase = rng_range(r, 200, 2000);
+        g->acc_target = 0; g->brk_target = 0;
+        g->cc_en = 1; g->cc_tgt = rng_range(r, 800, 1800); g->gear = rng_range(r, 3, 5);
+        break;
+    case PH_COAST:
+        g->left_in_phase = rng_range(r, 50, 500);
+        g->acc_target = 0; g->brk_target = 0;
+        break;
+    case PH_BRAKE:
+        g->left_in_phase = rng_range(r, 30, 200);
+        g->acc_target = 0; g->brk_target = rng_range(r, 10, 40);
+        break;
+    case PH_OVERLAP:
+        g->left_in_phase = rng_range(r, 10, 60);
+        g->acc_target = rng_range(r, 20, 45); g->brk_target = rng_range(r, 10, 45);
+        g->rate = 45;
+        break;
+    case PH_OVERREV:
+        g->left_in_phase = rng_range(r, 200, 600);
+        g->acc_target = 45; g->brk_target = 0; g->gear = rng_range(r, 1, 2);
+        g->rate = 5;
+        break;
+    default:
+        break;
+    }
+}
+
+// Produces one row into blk at index i.
+static void gen_row(gen_t *g, trace_block_t *blk, size_t i, long t) {
+    rng_t *r = &g->rng;
+    blk->t[i] = t;
+
+    if (g->off_rows > 0) {
+        g->off_rows--;
+        g->acc = g->brk = g->cc_en = 0;
+        blk->ign[i] = 0; blk->acc[i] = 0; blk->brk[i] = 0;
+        blk->gear[i] = g->gear; blk->cc_en[i] = 0; blk->cc_tgt[i] = g->cc_tgt;
+        if (g->off_rows == 0) {
+            g->left_in_trip = rng_range(r, 1000, 8000);
+            start_phase(g, PH_IDLE);
+        }
+        return;
+    }
+
+    if (--g->left_in_phase <= 0) start_phase(g, pick_phase(g));
+
+    g->acc = step_toward(g->acc, g->acc_target, g->rate);
+    g->brk = step_toward(g->brk, g->brk_target, g->rate);
+    if (g->phase == PH_ACCEL && g->gear < 5 && rng_chance(r, 8)) g->gear++;
+    if (g->phase == PH_BRAKE && g->gear > 1 && rng_chance(r, 15)) g->gear--;
+    if (g->phase != PH_CRUISE && g->phase != PH_OVERLAP && g->acc > 0 && rng_chance(r, 50)) {
+        g->acc += rng_range(r, -1, 1);      // foot jitter
+    }
+
+    int acc = g->acc, brk = g->brk, gear = g->gear;
+    if (rng_chance(r, 1)) acc  = rng_range(r, -3, 50);    // sensor glitches
+    if (rng_chance(r, 1)) brk  = rng_range(r, -3, 50);
+    if (rng_chance(r, 1)) gear = rng_range(r, 0, 7);
+
+    blk->ign[i] = 1; blk->acc[i] = acc; blk->brk[i] = brk;
+    blk->gear[i] = gear; blk->cc_en[i] = g->cc_en; blk->cc_tgt[i] = g->cc_tgt;
+
+    if (--g->left_in_trip <= 0) g->off_rows = rng_range(r, 20, 200);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <rows> <seed> <output.csv|.ecub>\n", argv[0]);
+        return 2;
+    }
+    long rows = atol(argv[1]);
+    const char *out_path = argv[3];
+
+    gen_t g;
+    memset(&g, 0, sizeof(g));
+    g.rng.s = strtoull(argv[2], NULL, 10);
+    g.gear = 1;
+    g.cc_tgt = 1000;
+    g.off_rows = 1;             // every trace starts with a key-on
+
+    size_t n = strlen(out_path);
+    int bin = n >= 5 && strcmp(out_path + n - 5, ".ecub") == 0;
+    writer_t *csv = NULL;
+    ecub_writer_t *ecub = NULL;
+    if (bin) {
+        ecub = ecub_create(out_path, ECUB_INPUT_SCHEMA, 7);
+    } else if ((csv = writer_open(out_path, WRITER_FLUSH_BATCH)) != NULL) {
+        writer_str(csv, "time,ignition_switch,acc_pedal_position,brake_pedal_position,"
+                        "current_gear,cruise_enable,cruise_target_speed");
+        writer_row_end(csv);
+    }
+    trace_block_t *blk = malloc(sizeof(*blk));
+    if ((!csv && !ecub) || !blk) {
+        fprintf(stderr, "open output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+
+    for (long t = 0; t < rows; ) {
+        size_t nb = 0;
+        while (nb < TRACE_BLOCK_ROWS && t < rows) gen_row(&g, blk, nb++, t++);
+        if (ecub) {
+            const void *cols[7] = { blk->t, blk->ign, blk->acc, blk->brk, blk->gear, blk->cc_en, blk->cc_tgt };
+            ecub_write_block(ecub, nb, cols);
+            continue;
+        }
+        for (size_t i = 0; i < nb; i++) {
+            const int *v[6] = { blk->ign, blk->acc, blk->brk, blk->gear, blk->cc_en, blk->cc_tgt };
+            writer_i64(csv, blk->t[i]);
+            for (int c = 0; c < 6; c++) { writer_char(csv, ','); writer_i64(csv, v[c][i]); }
+            writer_row_end(csv);
+        }
+    }
+
+    free(blk);
+    int rc = ecub ? ecub_finish(ecub) : writer_close(csv);
+    if (rc != 0) {
+        fprintf(stderr, "write output %s: %s\n", out_path, strerror(errno));
+        return 4;
+    }
+    return 0;
+}